@@ -0,0 +1,127 @@
+#ifndef ADAPTIVE_H
+#define ADAPTIVE_H
+
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include "vec3.h"
+#include "framebuffer.h"
+#include "sampler.h"
+#include "tile.h"
+
+class AdaptiveSettings {
+public:
+    int tileSize = 8;
+    int initialSamples = 4;
+    int batchSamples = 4;
+    int maxSamples = 64;
+    double targetNoise = 0.004; // erro padrão máximo aceito para a luminância de um pixel
+    SamplerType samplerType = SamplerType::OwenSobol;
+};
+
+// Acumula a média das amostras e a variância da luminância de cada pixel (algoritmo de Welford)
+class AccumulationBuffer {
+public:
+    int width, height;
+    std::vector<Vec3> mean;
+    std::vector<double> m2;
+    std::vector<int> count;
+
+    AccumulationBuffer(int w, int h) : width(w), height(h), mean(w * h), m2(w * h, 0.0), count(w * h, 0) {}
+
+    static double luminance(const Vec3& c) {
+        return 0.2126 * c.x + 0.7152 * c.y + 0.0722 * c.z;
+    }
+
+    void add(int x, int y, const Vec3& sample) {
+        int i = y * width + x;
+        double oldLum = luminance(mean[i]);
+        int n = ++count[i];
+        mean[i] = mean[i] + (sample - mean[i]) / n;
+        m2[i] += (luminance(sample) - oldLum) * (luminance(sample) - luminance(mean[i]));
+    }
+
+    double variance(int x, int y) const {
+        int i = y * width + x;
+        if (count[i] < 2) return std::numeric_limits<double>::max();
+        return m2[i] / (count[i] - 1);
+    }
+
+    // Erro padrão da média: cai com 1/sqrt(n) mesmo quando a variância é alta
+    double noise(int x, int y) const {
+        int n = count[y * width + x];
+        if (n < 2) return std::numeric_limits<double>::max();
+        return std::sqrt(variance(x, y) / n);
+    }
+};
+
+// Renderiza progressivamente: todos os tiles recebem initialSamples por pixel, depois
+// apenas os tiles cujo pior pixel ainda está acima de targetNoise recebem novos lotes,
+// até atingirem o alvo ou maxSamples. sample(px, py, lensU, lensV, time) devolve a cor de um raio em
+// coordenadas contínuas de pixel, com o ponto da lente em [0, 1)^2 (fixo em 0.5 sem sampleLens) e o
+// instante do obturador em [0, 1).
+// Retorna o total de amostras gastas.
+template <typename SampleFn>
+long long renderAdaptive(int width, int height, const AdaptiveSettings& settings, SampleFn sample, AccumulationBuffer& accum,
+                         bool sampleLens = false) {
+    std::vector<Tile> tiles = makeTiles(width, height, settings.tileSize);
+    Sampler sampler(settings.samplerType, settings.maxSamples);
+    std::vector<int> active(tiles.size());
+    for (size_t i = 0; i < tiles.size(); ++i) active[i] = int(i);
+
+    long long totalSamples = 0;
+    int samplesPerPixel = 0;
+    for (int pass = 0; !active.empty() && samplesPerPixel < settings.maxSamples; ++pass) {
+        int batch = pass == 0 ? settings.initialSamples : settings.batchSamples;
+        batch = std::min(batch, settings.maxSamples - samplesPerPixel);
+
+        for (int t : active) {
+            const Tile& tile = tiles[t];
+            for (int y = tile.y0; y < tile.y1; ++y) {
+                for (int x = tile.x0; x < tile.x1; ++x) {
+                    for (int s = 0; s < batch; ++s) {
+                        double jx, jy, lensU = 0.5, lensV = 0.5;
+                        uint32_t index = uint32_t(accum.count[y * width + x]);
+                        sampler.get2D(x, y, index, 0, jx, jy);
+                        // Dimensões 2 e 3 para a lente e 4 para o tempo: estratificadas junto com o jitter do pixel
+                        if (sampleLens) sampler.get2D(x, y, index, 2, lensU, lensV);
+                        double time = sampler.get1D(x, y, index, 4);
+                        accum.add(x, y, sample(x + jx, y + jy, lensU, lensV, time));
+                    }
+                }
+            }
+            totalSamples += (long long)batch * (tile.x1 - tile.x0) * (tile.y1 - tile.y0);
+        }
+        samplesPerPixel += batch;
+
+        std::vector<int> stillNoisy;
+        for (int t : active) {
+            const Tile& tile = tiles[t];
+            double tileNoise = 0.0;
+            for (int y = tile.y0; y < tile.y1; ++y) {
+                for (int x = tile.x0; x < tile.x1; ++x) {
+                    tileNoise = std::max(tileNoise, accum.noise(x, y));
+                }
+            }
+            if (tileNoise > settings.targetNoise) stillNoisy.push_back(t);
+        }
+        active.swap(stillNoisy);
+    }
+    return totalSamples;
+}
+
+// Mapa de calor das amostras gastas por pixel: azul = poucas, vermelho = maxSamples
+inline void writeSampleHeatmap(const AccumulationBuffer& accum, int maxSamples, std::vector<unsigned char>& image) {
+    for (int i = 0; i < accum.width * accum.height; ++i) {
+        double t = maxSamples > 0 ? double(accum.count[i]) / maxSamples : 0.0;
+        t = std::min(std::max(t, 0.0), 1.0);
+        Vec3 color = t < 0.5 ? Vec3(0, 2 * t, 1 - 2 * t) : Vec3(2 * t - 1, 2 - 2 * t, 0);
+        image[4 * i + 0] = toByte(color.x);
+        image[4 * i + 1] = toByte(color.y);
+        image[4 * i + 2] = toByte(color.z);
+        image[4 * i + 3] = 255;
+    }
+}
+
+#endif // ADAPTIVE_H
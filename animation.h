@@ -0,0 +1,242 @@
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+#include "scene.h"
+#include "scene_cache.h"
+#include "renderer.h"
+#include "framebuffer.h"
+#include "thread_pool.h"
+#include "lodepng.h"
+
+// Arquivo de animação, aplicado sobre a cena carregada. Uma diretiva por linha, '#' comenta:
+//   frames n
+//   shutter fração   fração do intervalo entre quadros com o obturador aberto (desfoque de movimento)
+//   camera quadro  px py pz  lx ly lz          chave da câmera: posição e alvo
+//   sphere índice quadro  cx cy cz             chave do centro de uma esfera
+// Entre chaves a interpolação é linear; antes da primeira e depois da última o valor fica parado.
+class Animation {
+public:
+    int frameCount = 1;
+    double shutter = 0.0;
+
+    struct Key {
+        double frame;
+        double value[6];
+    };
+
+    std::vector<Key> cameraKeys;
+    std::vector<std::pair<int, std::vector<Key>>> sphereKeys;  // índice da esfera e suas chaves
+
+    bool load(const std::string& path, std::string& error) {
+        std::ifstream file(path);
+        if (!file) {
+            error = "não foi possível abrir " + path;
+            return false;
+        }
+        std::string text;
+        int lineNumber = 0;
+        while (std::getline(file, text)) {
+            ++lineNumber;
+            size_t comment = text.find('#');
+            if (comment != std::string::npos) text.resize(comment);
+            std::istringstream line(text);
+            std::string keyword;
+            if (!(line >> keyword)) continue;
+            bool ok;
+            if (keyword == "frames") {
+                ok = bool(line >> frameCount) && frameCount > 0;
+            } else if (keyword == "shutter") {
+                ok = bool(line >> shutter) && shutter >= 0 && shutter <= 1;
+            } else if (keyword == "camera") {
+                Key key;
+                ok = readKey(line, key, 6);
+                if (ok) insertKey(cameraKeys, key);
+            } else if (keyword == "sphere") {
+                int index = -1;
+                Key key;
+                ok = bool(line >> index) && index >= 0 && readKey(line, key, 3);
+                if (ok) insertKey(keysForSphere(index), key);
+            } else {
+                error = "linha " + std::to_string(lineNumber) + ": diretiva desconhecida '" + keyword + "'";
+                return false;
+            }
+            std::string rest;
+            if (!ok || (line >> rest)) {
+                error = "linha " + std::to_string(lineNumber) + ": valores inválidos para '" + keyword + "'";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool movesSpheres() const { return !sphereKeys.empty(); }
+
+    Camera cameraAt(const Camera& base, int frame) const {
+        if (cameraKeys.empty()) return base;
+        double v[6];
+        interpolate(cameraKeys, frame, 6, v);
+        Camera camera = base;
+        camera.position = Point3(v[0], v[1], v[2]);
+        camera.lookAt = Point3(v[3], v[4], v[5]);
+        return camera;
+    }
+
+    // Centros no início do obturador e deslocamento até o fim dele, para o desfoque de movimento
+    void applySpheres(std::vector<Sphere>& spheres, int frame) const {
+        for (const auto& keyed : sphereKeys) {
+            if (keyed.first >= int(spheres.size())) continue;
+            double start[3], end[3];
+            interpolate(keyed.second, frame, 3, start);
+            interpolate(keyed.second, frame + shutter, 3, end);
+            Sphere& sphere = spheres[keyed.first];
+            sphere.center = Point3(start[0], start[1], start[2]);
+            sphere.motion = Vec3(end[0] - start[0], end[1] - start[1], end[2] - start[2]);
+        }
+    }
+
+private:
+    static bool readKey(std::istringstream& line, Key& key, int count) {
+        if (!(line >> key.frame)) return false;
+        for (int i = 0; i < count; ++i) {
+            if (!(line >> key.value[i])) return false;
+        }
+        return true;
+    }
+
+    static void insertKey(std::vector<Key>& keys, const Key& key) {
+        auto it = std::lower_bound(keys.begin(), keys.end(), key, [](const Key& a, const Key& b) { return a.frame < b.frame; });
+        keys.insert(it, key);
+    }
+
+    std::vector<Key>& keysForSphere(int index) {
+        for (auto& keyed : sphereKeys) {
+            if (keyed.first == index) return keyed.second;
+        }
+        sphereKeys.push_back(std::make_pair(index, std::vector<Key>()));
+        return sphereKeys.back().second;
+    }
+
+    static void interpolate(const std::vector<Key>& keys, double frame, int count, double* out) {
+        size_t next = 0;
+        while (next < keys.size() && keys[next].frame <= frame) ++next;
+        const Key& a = keys[next == 0 ? 0 : next - 1];
+        const Key& b = keys[next == keys.size() ? keys.size() - 1 : next];
+        double t = b.frame > a.frame ? (frame - a.frame) / (b.frame - a.frame) : 0.0;
+        t = std::min(std::max(t, 0.0), 1.0);
+        for (int i = 0; i < count; ++i) out[i] = a.value[i] + (b.value[i] - a.value[i]) * t;
+    }
+};
+
+class AnimationSettings {
+public:
+    std::string outputPattern = "frame_%04d.png";  // printf com o número do quadro; .ppm e .qoi gravam PPM e QOI
+    int inFlightFrames = 0;                          // quadros renderizando ao mesmo tempo, 0 = threads do pool
+    int encoderThreads = 2;
+    LodePNGCompressionPreset compression = LCP_DEFAULT;
+};
+
+// Quadros renderizados em paralelo por inFlightFrames threads, cada uma espalhando os tiles do seu
+// quadro no pool compartilhado. Quadros prontos vão para uma fila limitada consumida pelas threads
+// de codificação e escrita em disco; com a fila cheia a renderização espera, então no máximo
+// 2 * inFlightFrames imagens ficam na memória.
+class AnimationRenderer {
+public:
+    double renderMilliseconds = 0;  // soma do tempo de renderização de todos os quadros
+    double encodeMilliseconds = 0;  // soma do tempo de codificação e escrita
+    int failedFrames = 0;
+
+    bool render(const Scene& base, const Camera& camera, const RenderSettings& renderSettings, const Animation& animation,
+                const AnimationSettings& settings, ThreadPool& pool) {
+        RenderSettings frameSettings = renderSettings;
+        frameSettings.heatmapPath.clear();
+        frameSettings.workerProcesses = 0;   // os quadros rodam no pool, nunca nos workers
+        frameSettings.remoteWorkers.clear();
+        int inFlight = settings.inFlightFrames > 0 ? settings.inFlightFrames : pool.size();
+
+        // Cena mapeada é somente leitura: esferas animadas precisam de uma cópia editável
+        std::vector<Sphere> baseSpheres;
+        if (animation.movesSpheres()) {
+            ArrayView<Sphere> view = base.sphereView();
+            baseSpheres.assign(view.begin(), view.end());
+        }
+
+        BoundedQueue<Frame> encodeQueue(static_cast<size_t>(inFlight));
+        std::atomic<int> nextFrame(0);
+        std::atomic<long long> renderMicros(0), encodeMicros(0);
+        std::atomic<int> failures(0);
+
+        std::vector<std::thread> encoders;
+        for (int i = 0; i < std::max(1, settings.encoderThreads); ++i) {
+            encoders.emplace_back([&] {
+                Frame frame;
+                PNGMemoryPool memory;  // quadros do mesmo tamanho: sem alocações depois do primeiro
+                while (encodeQueue.pop(frame)) {
+                    auto start = std::chrono::steady_clock::now();
+                    if (!writeFrame(frame, settings, pool, memory)) ++failures;
+                    encodeMicros += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+                }
+            });
+        }
+
+        std::vector<std::thread> renderers;
+        for (int i = 0; i < inFlight; ++i) {
+            renderers.emplace_back([&] {
+                for (int index = nextFrame++; index < animation.frameCount; index = nextFrame++) {
+                    auto start = std::chrono::steady_clock::now();
+                    Scene scene = base;
+                    if (animation.movesSpheres()) {
+                        // Esferas animadas vão para vetores; numa cena mapeada planos e luzes também são copiados
+                        scene.spheres = baseSpheres;
+                        animation.applySpheres(scene.spheres, index);
+                        if (scene.mapping) {
+                            scene.planes.assign(base.mappedPlanes.begin(), base.mappedPlanes.end());
+                            scene.lights.assign(base.mappedLights.begin(), base.mappedLights.end());
+                            scene.mapping = nullptr;
+                        }
+                        if (scene.bvh) prepareSceneBVH(scene, "");
+                    }
+                    Frame frame;
+                    frame.index = index;
+                    frame.camera = animation.cameraAt(camera, index);
+                    frame.image.resize(size_t(frame.camera.hres) * frame.camera.vres * 4);
+                    renderImageParallel(scene, frame.camera, frameSettings, pool, frame.image);
+                    renderMicros += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+                    encodeQueue.push(std::move(frame));
+                }
+            });
+        }
+
+        for (auto& thread : renderers) thread.join();
+        encodeQueue.close();
+        for (auto& thread : encoders) thread.join();
+
+        renderMilliseconds = renderMicros / 1000.0;
+        encodeMilliseconds = encodeMicros / 1000.0;
+        failedFrames = failures;
+        return failedFrames == 0;
+    }
+
+private:
+    struct Frame {
+        int index = 0;
+        Camera camera = Camera(Point3(0, 0, 0), Point3(0, 0, -1), Vec3(0, 1, 0), 1.0, 0, 0);
+        std::vector<unsigned char> image;
+    };
+
+    static bool writeFrame(const Frame& frame, const AnimationSettings& settings, ThreadPool& pool, PNGMemoryPool& memory) {
+        return writeImageFile(numberedPath(settings.outputPattern, frame.index), frame.image, frame.camera.hres, frame.camera.vres,
+                              settings.compression, &pool, &memory);
+    }
+};
+
+#endif // ANIMATION_H
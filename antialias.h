@@ -0,0 +1,100 @@
+#ifndef ANTIALIAS_H
+#define ANTIALIAS_H
+
+#include <vector>
+#include <cmath>
+#include "vec3.h"
+#include "tile.h"
+
+class PrimarySample {
+public:
+    Vec3 color;
+    int id; // primitiva atingida, -1 para o fundo
+
+    PrimarySample() : color(), id(-1) {}
+    PrimarySample(Vec3 c, int i) : color(c), id(i) {}
+};
+
+class EdgeAASettings {
+public:
+    int maxDepth = 3;              // cada nível divide o pixel em 4: profundidade 3 = até 8x8 sub-amostras
+    double colorThreshold = 0.1;   // diferença máxima por canal entre cantos antes de subdividir
+};
+
+// Anti-aliasing adaptativo (Whitted): traça raios nos cantos dos pixels, compartilhados
+// entre vizinhos, e só subdivide os pixels cujos cantos atingem primitivas diferentes
+// ou têm cores discrepantes.
+class EdgeAdaptiveSampler {
+public:
+    EdgeAASettings settings;
+    long long raysTraced = 0;
+
+    explicit EdgeAdaptiveSampler(const EdgeAASettings& s) : settings(s) {}
+
+    // trace(px, py) devolve um PrimarySample para coordenadas contínuas de pixel
+    template <typename TraceFn>
+    void render(int width, int height, TraceFn trace, std::vector<Vec3>& output) {
+        renderTile(Tile(0, 0, width, height), trace, output.data(), width);
+    }
+
+    // Renderiza só o tile; out aponta para o pixel (x0, y0) e stride é a largura da linha de destino.
+    // Cantos são compartilhados dentro do tile, a borda entre tiles é traçada por ambos.
+    template <typename TraceFn>
+    void renderTile(const Tile& tile, TraceFn trace, Vec3* out, int stride) {
+        int tileWidth = tile.x1 - tile.x0;
+        std::vector<PrimarySample> top(tileWidth + 1), bottom(tileWidth + 1);
+        for (int i = 0; i <= tileWidth; ++i) top[i] = traceCounted(trace, tile.x0 + i, tile.y0);
+
+        for (int y = tile.y0; y < tile.y1; ++y) {
+            for (int i = 0; i <= tileWidth; ++i) bottom[i] = traceCounted(trace, tile.x0 + i, y + 1);
+            for (int i = 0; i < tileWidth; ++i) {
+                PrimarySample corners[4] = { top[i], top[i + 1], bottom[i], bottom[i + 1] };
+                out[(y - tile.y0) * stride + i] = refine(trace, tile.x0 + i, y, 1.0, corners, 0);
+            }
+            top.swap(bottom);
+        }
+    }
+
+private:
+    template <typename TraceFn>
+    PrimarySample traceCounted(TraceFn& trace, double px, double py) {
+        ++raysTraced;
+        return trace(px, py);
+    }
+
+    bool isEdge(const PrimarySample corners[4]) const {
+        for (int i = 1; i < 4; ++i) {
+            if (corners[i].id != corners[0].id) return true;
+            Vec3 d = corners[i].color - corners[0].color;
+            if (std::fabs(d.x) > settings.colorThreshold || std::fabs(d.y) > settings.colorThreshold ||
+                std::fabs(d.z) > settings.colorThreshold) return true;
+        }
+        return false;
+    }
+
+    // corners: (x, y), (x + size, y), (x, y + size), (x + size, y + size)
+    template <typename TraceFn>
+    Vec3 refine(TraceFn& trace, double x, double y, double size, const PrimarySample corners[4], int depth) {
+        if (depth >= settings.maxDepth || !isEdge(corners)) {
+            return (corners[0].color + corners[1].color + corners[2].color + corners[3].color) * 0.25;
+        }
+
+        double half = size * 0.5;
+        PrimarySample top = traceCounted(trace, x + half, y);
+        PrimarySample left = traceCounted(trace, x, y + half);
+        PrimarySample center = traceCounted(trace, x + half, y + half);
+        PrimarySample right = traceCounted(trace, x + size, y + half);
+        PrimarySample bottom = traceCounted(trace, x + half, y + size);
+
+        PrimarySample q0[4] = { corners[0], top, left, center };
+        PrimarySample q1[4] = { top, corners[1], center, right };
+        PrimarySample q2[4] = { left, center, corners[2], bottom };
+        PrimarySample q3[4] = { center, right, bottom, corners[3] };
+        return (refine(trace, x, y, half, q0, depth + 1) +
+                refine(trace, x + half, y, half, q1, depth + 1) +
+                refine(trace, x, y + half, half, q2, depth + 1) +
+                refine(trace, x + half, y + half, half, q3, depth + 1)) * 0.25;
+    }
+};
+
+#endif // ANTIALIAS_H
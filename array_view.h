@@ -0,0 +1,27 @@
+#ifndef ARRAY_VIEW_H
+#define ARRAY_VIEW_H
+
+#include <cstddef>
+#include <vector>
+
+// Visão somente leitura de um array contíguo: aponta para um std::vector ou para memória mapeada
+template <typename T>
+class ArrayView {
+public:
+    ArrayView() : ptr(nullptr), count(0) {}
+    ArrayView(const T* p, size_t n) : ptr(p), count(n) {}
+    ArrayView(const std::vector<T>& v) : ptr(v.data()), count(v.size()) {}
+
+    const T* data() const { return ptr; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const T& operator[](size_t i) const { return ptr[i]; }
+    const T* begin() const { return ptr; }
+    const T* end() const { return ptr + count; }
+
+private:
+    const T* ptr;
+    size_t count;
+};
+
+#endif // ARRAY_VIEW_H
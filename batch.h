@@ -0,0 +1,126 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include "scene.h"
+#include "camera.h"
+#include "tile.h"
+#include "renderer.h"
+#include "thread_pool.h"
+
+// Arquivo de vistas: uma câmera por linha, '#' comenta. Resolução, distância, lente e up
+// vêm da câmera base quando não informados.
+//   camera px py pz  lx ly lz  [ux uy uz]
+inline bool loadViews(const std::string& path, const Camera& base, std::vector<Camera>& cameras, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "não foi possível abrir " + path;
+        return false;
+    }
+    std::string text;
+    int lineNumber = 0;
+    while (std::getline(file, text)) {
+        ++lineNumber;
+        size_t comment = text.find('#');
+        if (comment != std::string::npos) text.resize(comment);
+        std::istringstream line(text);
+        std::string keyword;
+        if (!(line >> keyword)) continue;
+        Camera camera = base;
+        double v[6];
+        bool ok = keyword == "camera";
+        for (int i = 0; ok && i < 6; ++i) ok = bool(line >> v[i]);
+        if (!ok) {
+            error = "linha " + std::to_string(lineNumber) + ": esperado 'camera px py pz lx ly lz [ux uy uz]'";
+            return false;
+        }
+        camera.position = Point3(v[0], v[1], v[2]);
+        camera.lookAt = Point3(v[3], v[4], v[5]);
+        double up[3];
+        if (line >> up[0]) {
+            if (!(line >> up[1] >> up[2])) {
+                error = "linha " + std::to_string(lineNumber) + ": vetor up incompleto";
+                return false;
+            }
+            camera.up = Vec3(up[0], up[1], up[2]);
+        }
+        cameras.push_back(camera);
+    }
+    if (cameras.empty()) {
+        error = path + ": nenhuma câmera";
+        return false;
+    }
+    return true;
+}
+
+// count câmeras girando a posição da base em volta do alvo, no eixo up (fórmula de Rodrigues)
+inline std::vector<Camera> turntableCameras(const Camera& base, int count) {
+    std::vector<Camera> cameras;
+    Vec3 axis = base.up.normalize();
+    Vec3 offset(base.position.x - base.lookAt.x, base.position.y - base.lookAt.y, base.position.z - base.lookAt.z);
+    for (int i = 0; i < count; ++i) {
+        double angle = 2 * 3.14159265358979323846 * i / count;
+        double c = std::cos(angle), s = std::sin(angle);
+        Vec3 rotated = offset * c + axis.cross(offset) * s + axis * (axis.dot(offset) * (1 - c));
+        Camera camera = base;
+        camera.position = Point3(base.lookAt.x + rotated.x, base.lookAt.y + rotated.y, base.lookAt.z + rotated.z);
+        cameras.push_back(camera);
+    }
+    return cameras;
+}
+
+// Todas as vistas da mesma cena num único parallelFor, compartilhando cena e BVH. Os tiles são
+// intercalados entre as vistas (tile 0 de cada vista, depois tile 1, ...), então mesmo imagens
+// pequenas ocupam todos os núcleos e o fim de uma vista não deixa threads ociosas. O modo
+// VarianceAdaptive e o denoiser trabalham na imagem inteira: nesses casos cada vista é uma tarefa.
+inline void renderViews(const Scene& scene, const std::vector<Camera>& cameras, const RenderSettings& settings, ThreadPool& pool,
+                        std::vector<std::vector<unsigned char>>& images) {
+    images.resize(cameras.size());
+    for (size_t v = 0; v < cameras.size(); ++v) images[v].assign(size_t(cameras[v].hres) * cameras[v].vres * 4, 0);
+
+    if (settings.samplingMode == SamplingMode::VarianceAdaptive || settings.denoise) {
+        RenderSettings viewSettings = settings;
+        viewSettings.heatmapPath.clear();
+        viewSettings.workerProcesses = 0;   // as vistas rodam no pool, nunca nos workers
+        viewSettings.remoteWorkers.clear();
+        pool.parallelFor(int(cameras.size()), [&](int v) { renderImage(scene, cameras[v], viewSettings, images[v], &pool); });
+        return;
+    }
+
+    struct ViewTile {
+        int view;
+        Tile tile;
+    };
+    std::vector<std::vector<Tile>> tilesPerView;
+    size_t maxTiles = 0;
+    for (const auto& camera : cameras) {
+        tilesPerView.push_back(makeTiles(camera.hres, camera.vres, 32));
+        maxTiles = std::max(maxTiles, tilesPerView.back().size());
+    }
+    std::vector<ViewTile> work;
+    for (size_t t = 0; t < maxTiles; ++t) {
+        for (size_t v = 0; v < cameras.size(); ++v) {
+            if (t < tilesPerView[v].size()) work.push_back(ViewTile{ int(v), tilesPerView[v][t] });
+        }
+    }
+
+    pool.parallelFor(int(work.size()), [&](int i) {
+        const Camera& camera = cameras[work[i].view];
+        const Tile& tile = work[i].tile;
+        std::vector<unsigned char> pixels(size_t(tile.x1 - tile.x0) * (tile.y1 - tile.y0) * 4);
+        renderTileRGBA(scene, camera, settings, tile, pixels);
+        std::vector<unsigned char>& image = images[work[i].view];
+        size_t rowBytes = size_t(tile.x1 - tile.x0) * 4;
+        for (int y = tile.y0; y < tile.y1; ++y) {
+            std::memcpy(&image[(size_t(y) * camera.hres + tile.x0) * 4], &pixels[(y - tile.y0) * rowBytes], rowBytes);
+        }
+    });
+}
+
+#endif // BATCH_H
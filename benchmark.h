@@ -0,0 +1,442 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include "scene.h"
+#include "camera.h"
+#include "renderer.h"
+#include "framebuffer.h"
+#include "png_memory.h"
+#include "qoi.h"
+#include "hdr.h"
+#include "thread_pool.h"
+#include "lodepng.h"
+
+// Microbenchmarks das rotinas de saída de imagem, rodados com --benchmark <nome>
+
+// Repete fn até somar pelo menos minSeconds e devolve a vazão em GB/s
+template <typename Fn>
+inline double measureThroughput(size_t bytes, const Fn& fn, double minSeconds = 0.25) {
+    auto start = std::chrono::steady_clock::now();
+    long long runs = 0;
+    double seconds = 0;
+    do {
+        fn();
+        ++runs;
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (seconds < minSeconds);
+    return double(bytes) * runs / seconds / 1e9;
+}
+
+// Dados pseudoaleatórios: os checksums não dependem do conteúdo, mas evita páginas zeradas compartilhadas
+inline std::vector<unsigned char> benchmarkBuffer(size_t size) {
+    std::vector<unsigned char> data(size);
+    uint32_t state = 0x9e3779b9u;
+    for (auto& byte : data) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        byte = (unsigned char)state;
+    }
+    return data;
+}
+
+// Um conjunto de recursos da CPU a medir; features = 0 é o código portável
+struct ChecksumVariant {
+    const char* name;
+    unsigned features;
+};
+
+// Vazão do checksum em cada variante disponível e em pedaços paralelos no pool juntados com combine.
+// Todas as variantes precisam chegar ao resultado do código portável.
+template <typename Checksum, typename Combine>
+inline bool benchmarkChecksum(const std::string& title, const std::vector<ChecksumVariant>& variants, const Checksum& checksum,
+                              const Combine& combine, ThreadPool& pool) {
+    const size_t sizes[] = { 4 << 10, 64 << 10, 16 << 20 };
+    unsigned available = lodepng_cpu_features();
+    bool ok = true;
+    std::cout << title << " (GB/s)\n" << std::setw(10) << "bytes";
+    for (const auto& variant : variants) std::cout << std::setw(12) << variant.name;
+    std::cout << std::setw(12) << "paralelo" << "\n";
+    for (size_t size : sizes) {
+        std::vector<unsigned char> data = benchmarkBuffer(size);
+        volatile unsigned sink = 0;
+        unsigned expected = 0;
+        std::cout << std::setw(10) << size << std::fixed << std::setprecision(2);
+        for (const auto& variant : variants) {
+            if ((variant.features & available) != variant.features) {
+                std::cout << std::setw(12) << "-";
+                continue;
+            }
+            unsigned previous = lodepng_set_cpu_features(variant.features);
+            unsigned result = checksum(data.data(), size);
+            if (variant.features == 0) expected = result;
+            ok = ok && result == expected;
+            std::cout << std::setw(12) << measureThroughput(size, [&] { sink = checksum(data.data(), size); });
+            lodepng_set_cpu_features(previous);
+        }
+
+        int pieces = pool.size();
+        size_t pieceSize = (size + pieces - 1) / pieces;
+        std::vector<unsigned> partial(pieces);
+        auto parallel = [&] {
+            pool.parallelFor(pieces, [&](int i) {
+                size_t begin = std::min(size, i * pieceSize), end = std::min(size, begin + pieceSize);
+                partial[i] = checksum(data.data() + begin, end - begin);
+            });
+            unsigned result = partial[0];
+            for (int i = 1; i < pieces; ++i) {
+                size_t begin = std::min(size, i * pieceSize);
+                result = combine(result, partial[i], std::min(size, begin + pieceSize) - begin);
+            }
+            return result;
+        };
+        std::cout << std::setw(12) << measureThroughput(size, [&] { sink = parallel(); }) << "\n";
+        ok = ok && parallel() == expected;
+        (void)sink;
+    }
+    std::cout << "paralelo: " << pool.size() << " pedaços no pool; resultados " << (ok ? "conferem" : "DIVERGEM") << std::endl;
+    return ok;
+}
+
+inline bool benchmarkCrc32(ThreadPool& pool) {
+    return benchmarkChecksum("CRC32", { { "tabelas", 0 }, { "pclmul", LCPU_PCLMUL } },
+                             [](const unsigned char* data, size_t size) { return lodepng_crc32(data, size); },
+                             lodepng_crc32_combine, pool);
+}
+
+inline bool benchmarkAdler32(ThreadPool& pool) {
+    return benchmarkChecksum("Adler-32", { { "escalar", 0 }, { "ssse3", LCPU_SSSE3 }, { "avx2", LCPU_SSSE3 | LCPU_AVX2 } },
+                             [](const unsigned char* data, size_t size) { return lodepng_adler32_update(1, data, size); },
+                             lodepng_adler32_combine, pool);
+}
+
+// Imagem da cena e câmera atuais, como sai do renderizador, para medir os encoders em dados reais
+inline std::vector<unsigned char> benchmarkImage(const Scene& scene, const Camera& camera, ThreadPool& pool) {
+    RenderSettings settings;
+    settings.heatmapPath.clear();
+    std::vector<unsigned char> image(size_t(camera.hres) * camera.vres * 4);
+    renderImageParallel(scene, camera, settings, pool, image);
+    return image;
+}
+
+// Cada preset de compressão na imagem renderizada: vazão em MB/s de pixels RGBA e tamanho do arquivo.
+// Todo PNG é decodificado de volta e comparado com a imagem.
+inline bool benchmarkCompression(const Scene& scene, const Camera& camera, ThreadPool& pool) {
+    static const char* const names[] = { "store", "huffman", "rle", "fast", "default", "max" };
+    std::vector<unsigned char> image = benchmarkImage(scene, camera, pool);
+    bool ok = true;
+    std::cout << "Presets de compressão PNG em " << camera.hres << "x" << camera.vres << " (" << image.size() << " bytes RGBA)\n"
+              << std::setw(10) << "preset" << std::setw(12) << "MB/s" << std::setw(12) << "bytes" << std::setw(10) << "razão" << "\n";
+    for (int i = 0; i < 6; ++i) {
+        LodePNGCompressionPreset preset = LodePNGCompressionPreset(i);
+        std::vector<unsigned char> png, decoded;
+        double throughput = measureThroughput(image.size(), [&] {
+            png.clear();
+            encodePNG(image, camera.hres, camera.vres, png, preset);
+        }, 0.5);
+        unsigned width = 0, height = 0;
+        ok = ok && lodepng::decode(decoded, width, height, png) == 0 && decoded == image;
+        std::cout << std::setw(10) << names[i] << std::fixed << std::setprecision(1) << std::setw(12) << throughput * 1000
+                  << std::setw(12) << png.size() << std::setprecision(2) << std::setw(10) << double(image.size()) / png.size()
+                  << "\n";
+    }
+    std::cout << "decodificação " << (ok ? "confere" : "DIVERGE") << std::endl;
+    return ok;
+}
+
+// Filtragem das linhas do PNG na imagem renderizada, em MB/s de pixels RGBA: código portável, SSE2 e
+// SSE2 com as faixas de linhas no pool. O deflate fica em blocos sem compressão para o tempo ser o
+// dos filtros; as três variantes precisam gerar o mesmo arquivo.
+inline bool benchmarkFilters(const Scene& scene, const Camera& camera, ThreadPool& pool) {
+    static const char* const names[] = { "sub", "up", "average", "paeth", "minsum", "entropy" };
+    static const LodePNGFilterStrategy strategies[] = { LFS_ONE, LFS_TWO, LFS_THREE, LFS_FOUR, LFS_MINSUM, LFS_ENTROPY };
+    std::vector<unsigned char> image = benchmarkImage(scene, camera, pool);
+    bool ok = true;
+    std::cout << "Filtros PNG em " << camera.hres << "x" << camera.vres << " (MB/s)\n" << std::setw(10) << "filtro"
+              << std::setw(12) << "escalar" << std::setw(12) << "sse2" << std::setw(12) << "paralelo" << "\n";
+    for (int i = 0; i < 6; ++i) {
+        std::cout << std::setw(10) << names[i] << std::fixed << std::setprecision(1);
+        std::vector<unsigned char> expected;
+        for (int variant = 0; variant < 3; ++variant) {
+            if (variant > 0 && !(lodepng_cpu_features() & LCPU_SSE2)) {
+                std::cout << std::setw(12) << "-";
+                continue;
+            }
+            lodepng::State state;
+            state.encoder.zlibsettings.btype = 0;
+            state.encoder.filter_strategy = strategies[i];
+            if (variant == 2) {
+                state.encoder.parallel_for = lodepngParallelFor;
+                state.encoder.parallel_context = &pool;
+            }
+            unsigned previous = lodepng_set_cpu_features(variant == 0 ? 0 : ~0u);
+            std::vector<unsigned char> png;
+            double throughput = measureThroughput(image.size(), [&] {
+                png.clear();
+                lodepng::encode(png, image, camera.hres, camera.vres, state);
+            }, 0.5);
+            lodepng_set_cpu_features(previous);
+            if (variant == 0) expected = png;
+            ok = ok && !png.empty() && png == expected;
+            std::cout << std::setw(12) << throughput * 1000;
+        }
+        std::cout << "\n";
+    }
+    std::cout << "paralelo: " << pool.size() << " threads; arquivos " << (ok ? "conferem" : "DIVERGEM") << std::endl;
+    return ok;
+}
+
+// Buscadores de LZ77 na imagem renderizada, com os filtros do preset padrão: vazão do PNG inteiro em
+// MB/s de pixels RGBA e tamanho. Cada PNG é decodificado de volta e comparado com a imagem.
+inline bool benchmarkLZ77(const Scene& scene, const Camera& camera, ThreadPool& pool) {
+    struct Matcher {
+        const char* name;
+        LodePNGMatchFinder matchfinder;
+        unsigned windowsize, nicematch, lazymatching, maxchain;
+    };
+    static const Matcher matchers[] = {
+        { "chain 2K", LMF_CHAIN, 2048, 128, 1, 0 },
+        { "chain 32K", LMF_CHAIN, 32768, 258, 1, 0 },
+        { "rle", LMF_RLE, 32768, 258, 0, 0 },
+        { "fast", LMF_FAST, 32768, 32, 0, 0 },
+        { "hash4 4", LMF_HASH4, 32768, 64, 0, 4 },
+        { "hash4 16", LMF_HASH4, 32768, 128, 1, 16 },
+        { "hash4 64", LMF_HASH4, 32768, 258, 1, 64 },
+        { "hash4 256", LMF_HASH4, 32768, 258, 1, 256 },
+    };
+    std::vector<unsigned char> image = benchmarkImage(scene, camera, pool);
+    bool ok = true;
+    std::cout << "LZ77 em " << camera.hres << "x" << camera.vres << "\n" << std::setw(12) << "buscador" << std::setw(12) << "MB/s"
+              << std::setw(12) << "bytes" << "\n";
+    for (const Matcher& matcher : matchers) {
+        lodepng::State state;
+        setupPNGState(state, LCP_DEFAULT, &pool);
+        LodePNGCompressSettings& zlib = state.encoder.zlibsettings;
+        zlib.matchfinder = matcher.matchfinder;
+        zlib.windowsize = matcher.windowsize;
+        zlib.nicematch = matcher.nicematch;
+        zlib.lazymatching = matcher.lazymatching;
+        zlib.maxchain = matcher.maxchain;
+        std::vector<unsigned char> png, decoded;
+        double throughput = measureThroughput(image.size(), [&] {
+            png.clear();
+            lodepng::encode(png, image, camera.hres, camera.vres, state);
+        }, 0.5);
+        unsigned width = 0, height = 0;
+        ok = ok && lodepng::decode(decoded, width, height, png) == 0 && decoded == image;
+        std::cout << std::setw(12) << matcher.name << std::fixed << std::setprecision(1) << std::setw(12) << throughput * 1000
+                  << std::setw(12) << png.size() << "\n";
+    }
+    std::cout << "decodificação " << (ok ? "confere" : "DIVERGE") << std::endl;
+    return ok;
+}
+
+// Memória do lodepng na imagem renderizada: malloc a cada PNG contra um PNGMemoryPool reaproveitado,
+// em MB/s de pixels RGBA, e blocos pedidos ao heap pelo pool no primeiro PNG e nos seguintes.
+// Os arquivos das duas variantes precisam ser iguais.
+inline bool benchmarkMemory(const Scene& scene, const Camera& camera, ThreadPool& pool) {
+    static const char* const names[] = { "store", "huffman", "rle", "fast", "default", "max" };
+    std::vector<unsigned char> image = benchmarkImage(scene, camera, pool);
+    bool ok = true;
+    std::cout << "Alocação do lodepng em " << camera.hres << "x" << camera.vres << " (MB/s)\n" << std::setw(10) << "preset"
+              << std::setw(12) << "malloc" << std::setw(12) << "pool" << std::setw(14) << "1º PNG" << std::setw(14)
+              << "seguintes" << "\n";
+    for (int i = 0; i < 6; ++i) {
+        LodePNGCompressionPreset preset = LodePNGCompressionPreset(i);
+        std::vector<unsigned char> expected, png;
+        double heap = measureThroughput(image.size(), [&] {
+            expected.clear();
+            encodePNG(image, camera.hres, camera.vres, expected, preset, &pool);
+        }, 0.5);
+        PNGMemoryPool memory;
+        encodePNG(image, camera.hres, camera.vres, png, preset, &pool, &memory);
+        size_t first = memory.heapAllocations();
+        size_t runs = 0;
+        double pooled = measureThroughput(image.size(), [&] {
+            png.clear();
+            encodePNG(image, camera.hres, camera.vres, png, preset, &pool, &memory);
+            ++runs;
+        }, 0.5);
+        ok = ok && !png.empty() && png == expected;
+        std::cout << std::setw(10) << names[i] << std::fixed << std::setprecision(1) << std::setw(12) << heap * 1000
+                  << std::setw(12) << pooled * 1000 << std::setw(14) << first << std::setw(14)
+                  << double(memory.heapAllocations() - first) / runs << "\n";
+    }
+    std::cout << "arquivos " << (ok ? "conferem" : "DIVERGEM") << std::endl;
+    return ok;
+}
+
+// PNG num buffer (lodepng_encode) contra PNG escrito por blocos (lodepng_encode_stream), por preset:
+// vazão em MB/s de pixels RGBA e memória pedida pelo lodepng, medida num PNGMemoryPool novo para cada
+// variante. A saída do stream é descartada; os dois PNGs precisam decodificar para a mesma imagem.
+inline bool benchmarkStream(const Scene& scene, const Camera& camera, ThreadPool& pool) {
+    static const char* const names[] = { "store", "huffman", "rle", "fast", "default", "max" };
+    std::vector<unsigned char> image = benchmarkImage(scene, camera, pool);
+    bool ok = true;
+    std::cout << "PNG em buffer e em stream em " << camera.hres << "x" << camera.vres << "\n" << std::setw(10) << "preset"
+              << std::setw(12) << "buffer MB/s" << std::setw(12) << "stream MB/s" << std::setw(14) << "buffer MB mem"
+              << std::setw(14) << "stream MB mem" << "\n";
+    for (int i = 0; i < 6; ++i) {
+        LodePNGCompressionPreset preset = LodePNGCompressionPreset(i);
+        PNGMemoryPool bufferMemory, streamMemory;
+        std::vector<unsigned char> png, streamed;
+        double buffered = measureThroughput(image.size(), [&] {
+            png.clear();
+            encodePNG(image, camera.hres, camera.vres, png, preset, &pool, &bufferMemory);
+        }, 0.5);
+        LodePNGWriteCallback append = [](const unsigned char* data, size_t size, void* out) {
+            auto* bytes = static_cast<std::vector<unsigned char>*>(out);
+            bytes->insert(bytes->end(), data, data + size);
+            return 0u;
+        };
+        LodePNGWriteCallback discard = [](const unsigned char*, size_t, void*) { return 0u; };
+        auto encodeStream = [&](LodePNGWriteCallback write, void* context) {
+            PNGAllocatorScope scope(&streamMemory);
+            lodepng::State state;
+            setupPNGState(state, preset, &pool);
+            lodepng_encode_stream(write, context, image.data(), camera.hres, camera.vres, &state);
+        };
+        double stream = measureThroughput(image.size(), [&] { encodeStream(discard, nullptr); }, 0.5);
+        encodeStream(append, &streamed);
+        std::vector<unsigned char> a, b;
+        unsigned width = 0, height = 0;
+        ok = ok && lodepng::decode(a, width, height, png) == 0 && lodepng::decode(b, width, height, streamed) == 0 &&
+             a == b && a == image;
+        std::cout << std::setw(10) << names[i] << std::fixed << std::setprecision(1) << std::setw(12) << buffered * 1000
+                  << std::setw(12) << stream * 1000 << std::setw(14) << bufferMemory.reservedBytes() / 1048576.0
+                  << std::setw(14) << streamMemory.reservedBytes() / 1048576.0 << "\n";
+    }
+    std::cout << "decodificação " << (ok ? "confere" : "DIVERGE") << std::endl;
+    return ok;
+}
+
+// QOI contra PNG na imagem renderizada: vazão em MB/s de pixels RGBA e tamanho do arquivo. PNG com os
+// presets rápido e padrão (filtragem no pool), QOI serial e em faixas no pool. Todo arquivo é
+// decodificado de volta e comparado com a imagem.
+inline bool benchmarkQOI(const Scene& scene, const Camera& camera, ThreadPool& pool) {
+    std::vector<unsigned char> image = benchmarkImage(scene, camera, pool);
+    bool ok = true;
+    std::cout << "QOI e PNG em " << camera.hres << "x" << camera.vres << " (" << image.size() << " bytes RGBA)\n"
+              << std::setw(14) << "formato" << std::setw(12) << "MB/s" << std::setw(12) << "bytes" << std::setw(10) << "razão"
+              << "\n";
+    auto report = [&](const char* name, double throughput, size_t bytes) {
+        std::cout << std::setw(14) << name << std::fixed << std::setprecision(1) << std::setw(12) << throughput * 1000
+                  << std::setw(12) << bytes << std::setprecision(2) << std::setw(10) << double(image.size()) / bytes << "\n";
+    };
+    static const LodePNGCompressionPreset presets[] = { LCP_FAST, LCP_DEFAULT };
+    static const char* const pngNames[] = { "png fast", "png default" };
+    for (int i = 0; i < 2; ++i) {
+        std::vector<unsigned char> png, decoded;
+        double throughput = measureThroughput(image.size(), [&] {
+            png.clear();
+            encodePNG(image, camera.hres, camera.vres, png, presets[i], &pool);
+        }, 0.5);
+        unsigned width = 0, height = 0;
+        ok = ok && lodepng::decode(decoded, width, height, png) == 0 && decoded == image;
+        report(pngNames[i], throughput, png.size());
+    }
+    static const char* const qoiNames[] = { "qoi", "qoi paralelo" };
+    for (int parallel = 0; parallel < 2; ++parallel) {
+        std::vector<unsigned char> qoi, decoded;
+        double throughput = measureThroughput(image.size(), [&] {
+            encodeQOI(image, camera.hres, camera.vres, qoi, parallel ? &pool : nullptr);
+        }, 0.5);
+        int width = 0, height = 0;
+        ok = ok && decodeQOI(qoi.data(), qoi.size(), decoded, width, height) && decoded == image;
+        report(qoiNames[parallel], throughput, qoi.size());
+    }
+    std::vector<unsigned char> qoi, decoded;
+    encodeQOI(image, camera.hres, camera.vres, qoi);
+    int width = 0, height = 0;
+    double decodeThroughput = measureThroughput(image.size(), [&] {
+        decodeQOI(qoi.data(), qoi.size(), decoded, width, height);
+    }, 0.5);
+    std::cout << "decodificação QOI " << std::setprecision(1) << decodeThroughput * 1000 << " MB/s; paralelo: " << pool.size()
+              << " threads; arquivos " << (ok ? "conferem" : "DIVERGEM") << std::endl;
+    return ok;
+}
+
+// Conversão do framebuffer HDR em MB/s de floats lidos, para RGBA8 e RGB de 16 bits, por curva de
+// tone mapping: código portável, SSE2 e SSE2 com as faixas de linhas no pool. As variantes precisam
+// gerar os mesmos bytes, e a curva clamp sem exposição os mesmos do caminho de 8 bits.
+inline bool benchmarkHDR(const Scene& scene, const Camera& camera, ThreadPool& pool) {
+    static const char* const names[] = { "clamp", "reinhard", "aces" };
+    static const ToneMap curves[] = { ToneMap::Clamp, ToneMap::Reinhard, ToneMap::ACES };
+    RenderSettings settings;
+    settings.heatmapPath.clear();
+    std::vector<float> hdrImage;
+    renderImageHDR(scene, camera, settings, pool, hdrImage);
+    size_t pixels = size_t(camera.hres) * camera.vres;
+    size_t bytes = hdrImage.size() * sizeof(float);
+    bool ok = true;
+
+    std::vector<unsigned char> image = benchmarkImage(scene, camera, pool), toneMapped;
+    toneMapRGBA8(hdrImage, camera.hres, camera.vres, ToneMapSettings(), toneMapped);
+    size_t differences = 0;
+    for (size_t i = 0; i < image.size(); ++i) differences += image[i] != toneMapped[i];
+    ok = ok && differences == 0;
+
+    std::cout << "Conversão HDR em " << camera.hres << "x" << camera.vres << " (MB/s de floats; SSE2 "
+#ifdef HDR_SSE2
+              << "ativo"
+#else
+              << "indisponível"
+#endif
+              << ")\n" << std::setw(10) << "curva" << std::setw(14) << "8 portável" << std::setw(12) << "8 SSE2"
+              << std::setw(14) << "8 paralelo" << std::setw(14) << "16 portável" << std::setw(12) << "16 SSE2"
+              << std::setw(14) << "16 paralelo" << "\n";
+    for (int c = 0; c < 3; ++c) {
+        ToneMapSettings toneMap;
+        toneMap.curve = curves[c];
+        toneMap.exposure = 0.5;
+        float scale = float(std::exp2(toneMap.exposure));
+        std::vector<unsigned char> portable8(pixels * 4), simd8(pixels * 4), parallel8;
+        std::vector<unsigned char> portable16(pixels * 6), simd16(pixels * 6), parallel16(pixels * 6);
+        double throughput[6];
+        throughput[0] = measureThroughput(bytes, [&] {
+            hdr::toRGBA8Portable(hdrImage.data(), pixels, scale, toneMap.curve, portable8.data());
+        });
+        throughput[1] = measureThroughput(bytes, [&] { hdr::toRGBA8(hdrImage.data(), pixels, scale, toneMap.curve, simd8.data()); });
+        throughput[2] = measureThroughput(bytes, [&] {
+            toneMapRGBA8(hdrImage, camera.hres, camera.vres, toneMap, parallel8, &pool);
+        });
+        throughput[3] = measureThroughput(bytes, [&] {
+            hdr::toRGB16Portable(hdrImage.data(), pixels, scale, toneMap.curve, portable16.data());
+        });
+        throughput[4] = measureThroughput(bytes, [&] { hdr::toRGB16(hdrImage.data(), pixels, scale, toneMap.curve, simd16.data()); });
+        throughput[5] = measureThroughput(bytes, [&] {
+            hdr::convertRows(camera.hres, camera.vres, &pool, [&](size_t first, size_t count) {
+                hdr::toRGB16(&hdrImage[3 * first], count, scale, toneMap.curve, &parallel16[6 * first]);
+            });
+        });
+        ok = ok && simd8 == portable8 && parallel8 == portable8 && simd16 == portable16 && parallel16 == portable16;
+        std::cout << std::setw(10) << names[c] << std::fixed << std::setprecision(1);
+        for (int i = 0; i < 6; ++i) std::cout << std::setw(i % 3 == 1 ? 12 : 14) << throughput[i] * 1000;
+        std::cout << "\n";
+    }
+    std::cout << "clamp sem exposição: " << differences << " bytes diferentes do caminho de 8 bits; paralelo: " << pool.size()
+              << " threads; variantes " << (ok ? "conferem" : "DIVERGEM") << std::endl;
+    return ok;
+}
+
+inline bool runBenchmark(const std::string& name, const Scene& scene, const Camera& camera, ThreadPool& pool) {
+    if (name == "crc32") return benchmarkCrc32(pool);
+    if (name == "adler32") return benchmarkAdler32(pool);
+    if (name == "compression") return benchmarkCompression(scene, camera, pool);
+    if (name == "filters") return benchmarkFilters(scene, camera, pool);
+    if (name == "lz77") return benchmarkLZ77(scene, camera, pool);
+    if (name == "memory") return benchmarkMemory(scene, camera, pool);
+    if (name == "stream") return benchmarkStream(scene, camera, pool);
+    if (name == "qoi") return benchmarkQOI(scene, camera, pool);
+    if (name == "hdr") return benchmarkHDR(scene, camera, pool);
+    std::cout << "Benchmark desconhecido: " << name << " (disponíveis: crc32, adler32, compression, filters, lz77, memory, stream, qoi, hdr)" << std::endl;
+    return false;
+}
+
+#endif // BENCHMARK_H
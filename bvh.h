@@ -0,0 +1,414 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include "ray.h"
+#include "sphere.h"
+#include "plane.h"
+#include "intersection.h"
+#include "array_view.h"
+
+// Nó de 32 bytes. Filhos de um nó interno ficam lado a lado: esquerdo = first, direito = first + 1.
+// Limites em float arredondados para fora, então nunca perdem uma interseção.
+struct BVHNode {
+    float boundsMin[3];
+    uint32_t first;  // folha: primeira posição em indices; interno: índice do filho esquerdo
+    float boundsMax[3];
+    uint32_t count;  // > 0 indica folha
+};
+
+namespace bvhdetail {
+
+struct Bounds {
+    double lo[3], hi[3];
+
+    Bounds() {
+        for (int a = 0; a < 3; ++a) {
+            lo[a] = std::numeric_limits<double>::max();
+            hi[a] = -std::numeric_limits<double>::max();
+        }
+    }
+
+    void grow(const double p[3]) {
+        for (int a = 0; a < 3; ++a) {
+            lo[a] = std::min(lo[a], p[a]);
+            hi[a] = std::max(hi[a], p[a]);
+        }
+    }
+
+    void grow(const Bounds& b) {
+        grow(b.lo);
+        grow(b.hi);
+    }
+
+    double area() const {
+        double dx = hi[0] - lo[0], dy = hi[1] - lo[1], dz = hi[2] - lo[2];
+        if (dx < 0) return 0.0;
+        return 2.0 * (dx * dy + dy * dz + dz * dx);
+    }
+};
+
+// Caixa das posições inicial e final: cobre todo o movimento linear durante o obturador
+inline Bounds sphereBounds(const Sphere& s) {
+    Bounds b;
+    double c0[3] = { s.center.x, s.center.y, s.center.z };
+    double c1[3] = { s.center.x + s.motion.x, s.center.y + s.motion.y, s.center.z + s.motion.z };
+    for (int a = 0; a < 3; ++a) {
+        b.lo[a] = std::min(c0[a], c1[a]) - s.radius;
+        b.hi[a] = std::max(c0[a], c1[a]) + s.radius;
+    }
+    return b;
+}
+
+inline float roundDown(double v) {
+    float f = float(v);
+    return double(f) > v ? std::nextafter(f, -std::numeric_limits<float>::infinity()) : f;
+}
+
+inline float roundUp(double v) {
+    float f = float(v);
+    return double(f) < v ? std::nextafter(f, std::numeric_limits<float>::infinity()) : f;
+}
+
+// Hash de conteúdo de 64 bits, 8 bytes por passo (mistura no estilo do splitmix64)
+inline uint64_t mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+inline uint64_t hashBytes(const void* data, size_t size, uint64_t seed) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    uint64_t h[4] = { seed, seed ^ 0x9e3779b97f4a7c15ull, seed + 0x632be59bd9b4e019ull, ~seed };
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (int lane = 0; lane < 4; ++lane) {
+            uint64_t word;
+            std::memcpy(&word, p + i + 8 * lane, 8);
+            h[lane] = mix(h[lane] ^ word) * 0x9e3779b97f4a7c15ull;
+        }
+    }
+    uint64_t result = mix(h[0] ^ mix(h[1]) ^ mix(mix(h[2])) ^ mix(mix(mix(h[3]))) ^ size);
+    for (; i < size; ++i) result = mix(result ^ p[i]);
+    return result;
+}
+
+} // namespace bvhdetail
+
+// Hash do conteúdo das esferas e planos: identifica o arquivo de cache da hierarquia
+inline uint64_t sceneGeometryHash(ArrayView<Sphere> spheres, ArrayView<Plane> planes) {
+    uint64_t h = bvhdetail::hashBytes(spheres.data(), spheres.size() * sizeof(Sphere), 0x5047425648ull);
+    return bvhdetail::hashBytes(planes.data(), planes.size() * sizeof(Plane), h);
+}
+
+// Hierarquia de volumes envolventes sobre as esferas, construída por SAH com bins.
+// Os planos são infinitos e continuam sendo testados um a um pelo renderizador.
+class BVH {
+public:
+    uint64_t geometryHash = 0;
+    ArrayView<BVHNode> nodes;
+    ArrayView<uint32_t> indices;
+
+    static const int MAX_LEAF_SIZE = 4;
+    static const int BIN_COUNT = 16;
+
+    // Primeira interseção com esferas; closestDistance entra como limite e sai atualizado
+    bool intersect(const Ray& ray, ArrayView<Sphere> spheres, Intersection& closest, double& closestDistance) const {
+        if (nodes.empty()) return false;
+        double invDir[3] = { 1.0 / ray.direction.x, 1.0 / ray.direction.y, 1.0 / ray.direction.z };
+        double origin[3] = { ray.origin.x, ray.origin.y, ray.origin.z };
+        uint32_t stack[64];
+        int top = 0;
+        stack[top++] = 0;
+        bool found = false;
+        while (top > 0) {
+            const BVHNode& node = nodes[stack[--top]];
+            if (!hitsBox(node, origin, invDir, closestDistance)) continue;
+            if (node.count > 0) {
+                for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                    Intersection intersection(0, Vec3());
+                    uint32_t index = indices[i];
+                    if (spheres[index].intersect(ray, intersection) && intersection.distance < closestDistance) {
+                        closestDistance = intersection.distance;
+                        closest = intersection;
+                        closest.id = int(index);
+                        found = true;
+                    }
+                }
+                continue;
+            }
+            // Filho mais próximo no topo da pilha para encolher closestDistance mais cedo
+            uint32_t near = node.first, far = node.first + 1;
+            if (boxEntry(nodes[far], origin, invDir) < boxEntry(nodes[near], origin, invDir)) std::swap(near, far);
+            if (top + 2 <= 64) {
+                stack[top++] = far;
+                stack[top++] = near;
+            }
+        }
+        return found;
+    }
+
+    bool occluded(const Ray& ray, double maxDistance, ArrayView<Sphere> spheres) const {
+        if (nodes.empty()) return false;
+        double invDir[3] = { 1.0 / ray.direction.x, 1.0 / ray.direction.y, 1.0 / ray.direction.z };
+        double origin[3] = { ray.origin.x, ray.origin.y, ray.origin.z };
+        uint32_t stack[64];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const BVHNode& node = nodes[stack[--top]];
+            if (!hitsBox(node, origin, invDir, maxDistance)) continue;
+            if (node.count > 0) {
+                for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                    Intersection intersection(0, Vec3());
+                    if (spheres[indices[i]].intersect(ray, intersection) && intersection.distance < maxDistance) return true;
+                }
+            } else if (top + 2 <= 64) {
+                stack[top++] = node.first;
+                stack[top++] = node.first + 1;
+            }
+        }
+        return false;
+    }
+
+    static std::shared_ptr<BVH> build(ArrayView<Sphere> spheres, uint64_t hash) {
+        std::shared_ptr<BVH> bvh = std::make_shared<BVH>();
+        bvh->geometryHash = hash;
+        if (spheres.empty()) return bvh;
+
+        std::vector<bvhdetail::Bounds> bounds(spheres.size());
+        std::vector<double> centroids(spheres.size() * 3);
+        for (size_t i = 0; i < spheres.size(); ++i) {
+            bounds[i] = bvhdetail::sphereBounds(spheres[i]);
+            Point3 c = spheres[i].sweptCenter();
+            centroids[3 * i + 0] = c.x;
+            centroids[3 * i + 1] = c.y;
+            centroids[3 * i + 2] = c.z;
+        }
+        bvh->ownedIndices.resize(spheres.size());
+        for (size_t i = 0; i < spheres.size(); ++i) bvh->ownedIndices[i] = uint32_t(i);
+        bvh->ownedNodes.reserve(2 * spheres.size() / MAX_LEAF_SIZE + 1);
+        bvh->ownedNodes.push_back(BVHNode());
+        bvh->subdivide(0, 0, uint32_t(spheres.size()), bounds, centroids, 0);
+        bvh->nodes = ArrayView<BVHNode>(bvh->ownedNodes);
+        bvh->indices = ArrayView<uint32_t>(bvh->ownedIndices);
+        return bvh;
+    }
+
+    // Arquivo: cabeçalho + nós + índices, seções alinhadas a 64 bytes para uso direto após mmap
+    bool save(const std::string& path) const {
+        Header header = makeHeader();
+        header.checksum = payloadChecksum(nodes.data(), indices.data());
+        FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) return false;
+        std::vector<unsigned char> padding(header.nodesOffset - sizeof(Header), 0);
+        std::vector<unsigned char> padding2(header.indicesOffset - header.nodesOffset - nodes.size() * sizeof(BVHNode), 0);
+        bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  std::fwrite(padding.data(), 1, padding.size(), file) == padding.size() &&
+                  std::fwrite(nodes.data(), sizeof(BVHNode), nodes.size(), file) == nodes.size() &&
+                  std::fwrite(padding2.data(), 1, padding2.size(), file) == padding2.size() &&
+                  std::fwrite(indices.data(), sizeof(uint32_t), indices.size(), file) == indices.size();
+        return std::fclose(file) == 0 && ok;
+    }
+
+    // mapped: arquivo inteiro já em memória (MappedFile); a BVH mantém keepAlive vivo
+    static std::shared_ptr<BVH> fromMemory(const unsigned char* data, size_t size, uint64_t expectedHash,
+                                           size_t sphereCount, std::shared_ptr<const void> keepAlive) {
+        Header header;
+        if (size < sizeof(Header)) return nullptr;
+        std::memcpy(&header, data, sizeof(header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+            header.nodeSize != sizeof(BVHNode) || header.geometryHash != expectedHash || header.indexCount != sphereCount) {
+            return nullptr;
+        }
+        // Divisões em vez de produtos: contagens absurdas no cabeçalho não dão a volta no uint64
+        if (header.nodesOffset % 64 || header.indicesOffset % 64 || header.nodesOffset < sizeof(Header) ||
+            header.nodesOffset > header.indicesOffset || header.indicesOffset > size ||
+            header.nodeCount > (header.indicesOffset - header.nodesOffset) / sizeof(BVHNode) ||
+            header.indexCount > (size - header.indicesOffset) / sizeof(uint32_t)) {
+            return nullptr;
+        }
+        std::shared_ptr<BVH> bvh = std::make_shared<BVH>();
+        bvh->geometryHash = header.geometryHash;
+        bvh->nodes = ArrayView<BVHNode>(reinterpret_cast<const BVHNode*>(data + header.nodesOffset), size_t(header.nodeCount));
+        bvh->indices = ArrayView<uint32_t>(reinterpret_cast<const uint32_t*>(data + header.indicesOffset), size_t(header.indexCount));
+        if (bvh->payloadChecksum(bvh->nodes.data(), bvh->indices.data()) != header.checksum) return nullptr;
+        for (uint32_t index : bvh->indices) {
+            if (index >= sphereCount) return nullptr;
+        }
+        // A travessia confia nos nós: folhas dentro de indices e filhos depois do pai, o que também
+        // impede ciclos
+        for (size_t i = 0; i < bvh->nodes.size(); ++i) {
+            const BVHNode& node = bvh->nodes[i];
+            if (node.count > 0 ? uint64_t(node.first) + node.count > header.indexCount
+                               : node.first <= i || uint64_t(node.first) + 1 >= header.nodeCount) {
+                return nullptr;
+            }
+        }
+        bvh->keepAlive = keepAlive;
+        return bvh;
+    }
+
+private:
+    static constexpr char MAGIC[8] = { 'P', 'G', 'B', 'V', 'H', 0, 0, 0 };
+    static const uint32_t VERSION = 2;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t nodeSize;
+        uint64_t geometryHash;
+        uint64_t nodeCount, indexCount;
+        uint64_t nodesOffset, indicesOffset;
+        uint64_t checksum;
+    };
+
+    std::vector<BVHNode> ownedNodes;
+    std::vector<uint32_t> ownedIndices;
+    std::shared_ptr<const void> keepAlive;
+
+    Header makeHeader() const {
+        Header header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.nodeSize = sizeof(BVHNode);
+        header.geometryHash = geometryHash;
+        header.nodeCount = nodes.size();
+        header.indexCount = indices.size();
+        header.nodesOffset = 64;
+        header.indicesOffset = (header.nodesOffset + nodes.size() * sizeof(BVHNode) + 63) / 64 * 64;
+        return header;
+    }
+
+    uint64_t payloadChecksum(const BVHNode* nodeData, const uint32_t* indexData) const {
+        uint64_t h = bvhdetail::hashBytes(nodeData, nodes.size() * sizeof(BVHNode), geometryHash);
+        return bvhdetail::hashBytes(indexData, indices.size() * sizeof(uint32_t), h);
+    }
+
+    static bool hitsBox(const BVHNode& node, const double origin[3], const double invDir[3], double maxDistance) {
+        double tNear = 0.0, tFar = maxDistance;
+        for (int a = 0; a < 3; ++a) {
+            double t0 = (node.boundsMin[a] - origin[a]) * invDir[a];
+            double t1 = (node.boundsMax[a] - origin[a]) * invDir[a];
+            if (t0 > t1) std::swap(t0, t1);
+            tNear = t0 > tNear ? t0 : tNear;
+            tFar = t1 < tFar ? t1 : tFar;
+            if (tNear > tFar) return false;
+        }
+        return true;
+    }
+
+    static double boxEntry(const BVHNode& node, const double origin[3], const double invDir[3]) {
+        double tNear = -std::numeric_limits<double>::max();
+        for (int a = 0; a < 3; ++a) {
+            double t0 = (node.boundsMin[a] - origin[a]) * invDir[a];
+            double t1 = (node.boundsMax[a] - origin[a]) * invDir[a];
+            tNear = std::max(tNear, std::min(t0, t1));
+        }
+        return tNear;
+    }
+
+    void setLeaf(uint32_t nodeIndex, uint32_t first, uint32_t count, const bvhdetail::Bounds& b) {
+        BVHNode& node = ownedNodes[nodeIndex];
+        for (int a = 0; a < 3; ++a) {
+            node.boundsMin[a] = bvhdetail::roundDown(b.lo[a]);
+            node.boundsMax[a] = bvhdetail::roundUp(b.hi[a]);
+        }
+        node.first = first;
+        node.count = count;
+    }
+
+    void subdivide(uint32_t nodeIndex, uint32_t first, uint32_t count, const std::vector<bvhdetail::Bounds>& bounds,
+                   const std::vector<double>& centroids, int depth) {
+        bvhdetail::Bounds nodeBounds, centroidBounds;
+        for (uint32_t i = first; i < first + count; ++i) {
+            nodeBounds.grow(bounds[ownedIndices[i]]);
+            centroidBounds.grow(&centroids[3 * ownedIndices[i]]);
+        }
+        setLeaf(nodeIndex, first, count, nodeBounds);
+        // Profundidade limitada pelo tamanho da pilha de travessia
+        if (count <= uint32_t(MAX_LEAF_SIZE) || depth >= 60) return;
+
+        int axis = 0;
+        for (int a = 1; a < 3; ++a) {
+            if (centroidBounds.hi[a] - centroidBounds.lo[a] > centroidBounds.hi[axis] - centroidBounds.lo[axis]) axis = a;
+        }
+        double extent = centroidBounds.hi[axis] - centroidBounds.lo[axis];
+
+        uint32_t mid = first;
+        if (extent > 0) {
+            bvhdetail::Bounds binBounds[BIN_COUNT];
+            uint32_t binCounts[BIN_COUNT] = { 0 };
+            double scale = BIN_COUNT / extent;
+            for (uint32_t i = first; i < first + count; ++i) {
+                uint32_t index = ownedIndices[i];
+                int bin = std::min(BIN_COUNT - 1, int((centroids[3 * index + axis] - centroidBounds.lo[axis]) * scale));
+                binBounds[bin].grow(bounds[index]);
+                ++binCounts[bin];
+            }
+            // Custo SAH de cada plano entre bins, varrendo da direita e depois da esquerda
+            double rightArea[BIN_COUNT];
+            uint32_t rightCount[BIN_COUNT];
+            bvhdetail::Bounds accumulated;
+            uint32_t accumulatedCount = 0;
+            for (int b = BIN_COUNT - 1; b > 0; --b) {
+                accumulated.grow(binBounds[b]);
+                accumulatedCount += binCounts[b];
+                rightArea[b] = accumulated.area();
+                rightCount[b] = accumulatedCount;
+            }
+            double bestCost = std::numeric_limits<double>::max();
+            int bestSplit = -1;
+            accumulated = bvhdetail::Bounds();
+            accumulatedCount = 0;
+            for (int b = 1; b < BIN_COUNT; ++b) {
+                accumulated.grow(binBounds[b - 1]);
+                accumulatedCount += binCounts[b - 1];
+                if (accumulatedCount == 0 || rightCount[b] == 0) continue;
+                double cost = accumulated.area() * accumulatedCount + rightArea[b] * rightCount[b];
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestSplit = b;
+                }
+            }
+            if (bestSplit > 0) {
+                uint32_t* begin = &ownedIndices[first];
+                uint32_t* middle = std::partition(begin, begin + count, [&](uint32_t index) {
+                    int bin = std::min(BIN_COUNT - 1, int((centroids[3 * index + axis] - centroidBounds.lo[axis]) * scale));
+                    return bin < bestSplit;
+                });
+                mid = first + uint32_t(middle - begin);
+            }
+        }
+        if (mid == first || mid == first + count) {
+            // Centroides coincidentes ou partição degenerada: divide pela mediana
+            mid = first + count / 2;
+            std::nth_element(&ownedIndices[first], &ownedIndices[mid], &ownedIndices[first] + count,
+                             [&](uint32_t a, uint32_t b) { return centroids[3 * a + axis] < centroids[3 * b + axis]; });
+        }
+
+        uint32_t left = uint32_t(ownedNodes.size());
+        ownedNodes.push_back(BVHNode());
+        ownedNodes.push_back(BVHNode());
+        ownedNodes[nodeIndex].first = left;
+        ownedNodes[nodeIndex].count = 0;
+        subdivide(left, first, mid - first, bounds, centroids, depth + 1);
+        subdivide(left + 1, mid, first + count - mid, bounds, centroids, depth + 1);
+    }
+};
+
+constexpr char BVH::MAGIC[8];
+
+#endif // BVH_H
@@ -4,6 +4,33 @@
 #include "point3.h"
 #include "vec3.h"
 #include "ray.h"
+#include <cmath>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CAMERA_SSE2
+#endif
+
+enum class Projection {
+    Perspective,      // plano de imagem a distance do olho
+    Equirectangular,  // panorama 360° x 180°: longitude ao longo de x, latitude ao longo de y
+    CubeMap           // seis faces de vres x vres lado a lado (hres = 6 * vres): +u -u +v -v +w -w; olhando
+                      // para -z com up +y são as faces +x -x +y -y +z -z do OpenGL
+};
+
+const int MAX_IMAGE_DIMENSION = 16384;  // largura ou altura máxima de uma imagem, em pixels
+
+// Nomes aceitos na linha de comando e nos pedidos ao servidor
+inline bool parseProjection(const std::string& name, Projection& projection) {
+    if (name == "perspective") projection = Projection::Perspective;
+    else if (name == "equirect") projection = Projection::Equirectangular;
+    else if (name == "cubemap") projection = Projection::CubeMap;
+    else return false;
+    return true;
+}
 
 class Camera {
 public:
@@ -12,6 +39,9 @@ public:
     Vec3 up;
     double distance;
     int vres, hres;
+    double aperture = 0.0;       // raio da lente fina; 0 = pinhole
+    double focusDistance = 1.0;  // distância do plano em foco, medida ao longo do eixo de visão
+    Projection projection = Projection::Perspective;
 
     Camera(Point3 pos, Point3 look, Vec3 upVec, double dist, int vertRes, int horizRes)
         : position(pos), lookAt(look), up(upVec), distance(dist), vres(vertRes), hres(horizRes) {}
@@ -23,14 +53,166 @@ public:
     }
 
     Ray getRay(int x, int y) const {
+        return getRay(x + 0.5, y + 0.5);
+    }
+
+    // As projeções panorâmicas partem todas do centro da lente
+    bool thinLens() const { return aperture > 0 && projection == Projection::Perspective; }
+
+    // px, py em coordenadas contínuas de pixel (x + 0.5 é o centro do pixel x)
+    Ray getRay(double px, double py) const {
         Vec3 u, v, w;
         getCameraBasis(u, v, w);
-        double aspect_ratio = double(hres) / double(vres);
-        double u_coord = (2 * ((x + 0.5) / hres) - 1) * aspect_ratio;
-        double v_coord = 1 - 2 * ((y + 0.5) / vres);
-        Vec3 direction = (u_coord * u + v_coord * v - distance * w).normalize();
-        return Ray(position, direction);
+        Vec3 p, q, r;
+        columnTerms(px, u, v, w, p, q, r);
+        double scale, t;
+        rowTerms(py, scale, t);
+        return Ray(position, (p * scale + q * t + r).normalize());
+    }
+
+    // A direção de um pixel é normalize(p * scale + q * t + r): p, q e r dependem só da coluna e
+    // scale, t só da linha. Na perspectiva é (u_coord * u + v_coord * v - distance * w).
+    void columnTerms(double px, const Vec3& u, const Vec3& v, const Vec3& w, Vec3& p, Vec3& q, Vec3& r) const {
+        if (projection == Projection::Equirectangular) {
+            double phi = 2 * PI * (px / hres) - PI;
+            p = std::sin(phi) * u - std::cos(phi) * w;
+            q = v;
+            r = Vec3();
+        } else if (projection == Projection::CubeMap) {
+            int face = std::min(5, std::max(0, int(px / vres)));
+            double s = 2 * ((px - face * vres) / vres) - 1;
+            static const double axes[6][3][3] = {
+                // eixo s, eixo t e normal da face, em coordenadas (u, v, w)
+                { { 0, 0, -1 }, { 0, -1, 0 }, { 1, 0, 0 } },  { { 0, 0, 1 }, { 0, -1, 0 }, { -1, 0, 0 } },
+                { { 1, 0, 0 }, { 0, 0, 1 }, { 0, 1, 0 } },    { { 1, 0, 0 }, { 0, 0, -1 }, { 0, -1, 0 } },
+                { { 1, 0, 0 }, { 0, -1, 0 }, { 0, 0, 1 } },   { { -1, 0, 0 }, { 0, -1, 0 }, { 0, 0, -1 } },
+            };
+            const double(*a)[3] = axes[face];
+            p = s * (a[0][0] * u + a[0][1] * v + a[0][2] * w);
+            q = a[1][0] * u + a[1][1] * v + a[1][2] * w;
+            r = a[2][0] * u + a[2][1] * v + a[2][2] * w;
+        } else {
+            double aspect_ratio = double(hres) / double(vres);
+            double u_coord = (2 * (px / hres) - 1) * aspect_ratio;
+            p = u_coord * u;
+            q = v;
+            Vec3 back = distance * w;
+            r = Vec3(-back.x, -back.y, -back.z);
+        }
+    }
+
+    void rowTerms(double py, double& scale, double& t) const {
+        if (projection == Projection::Equirectangular) {
+            double theta = PI / 2 - PI * (py / vres);
+            scale = std::cos(theta);
+            t = std::sin(theta);
+        } else if (projection == Projection::CubeMap) {
+            scale = 1;
+            t = 2 * (py / vres) - 1;
+        } else {
+            scale = 1;
+            t = 1 - 2 * (py / vres);
+        }
+    }
+
+    // Lente fina: lensU, lensV em [0, 1)^2 escolhem o ponto na abertura. Todos os raios do pixel
+    // convergem no plano em foco. Com aperture = 0 é o raio pinhole, sem amostrar a lente.
+    Ray getRay(double px, double py, double lensU, double lensV) const {
+        Ray pinhole = getRay(px, py);
+        if (!thinLens()) return pinhole;
+        Vec3 u, v, w;
+        getCameraBasis(u, v, w);
+        double t = focusDistance / -pinhole.direction.dot(w);
+        Point3 focus(position.x + pinhole.direction.x * t, position.y + pinhole.direction.y * t,
+                     position.z + pinhole.direction.z * t);
+        double lx, ly;
+        concentricDisk(lensU, lensV, lx, ly);
+        Vec3 offset = (lx * aperture) * u + (ly * aperture) * v;
+        Point3 origin(position.x + offset.x, position.y + offset.y, position.z + offset.z);
+        return Ray(origin, Vec3(focus.x - origin.x, focus.y - origin.y, focus.z - origin.z).normalize());
+    }
+
+    static constexpr double PI = 3.14159265358979323846;
+
+    // Mapeamento concêntrico de Shirley-Chiu: preserva a estratificação do quadrado no disco
+    static void concentricDisk(double su, double sv, double& x, double& y) {
+        double a = 2 * su - 1, b = 2 * sv - 1;
+        if (a == 0 && b == 0) {
+            x = y = 0;
+            return;
+        }
+        const double quarterPi = PI / 4;
+        double r, phi;
+        if (std::fabs(a) > std::fabs(b)) {
+            r = a;
+            phi = quarterPi * (b / a);
+        } else {
+            r = b;
+            phi = 2 * quarterPi - quarterPi * (a / b);
+        }
+        x = r * std::cos(phi);
+        y = r * std::sin(phi);
+    }
+};
+
+// Direções dos raios primários de um intervalo de colunas, uma linha por vez. Os termos de coluna
+// (inclusive seno e cosseno da longitude na equirretangular) são calculados uma vez por intervalo;
+// cada linha combina dois pixels por instrução SSE2, com o mesmo resultado de Camera::getRay.
+class RayRowGenerator {
+public:
+    RayRowGenerator(const Camera& camera, int x0, int x1) : camera(camera), count(std::max(0, x1 - x0)) {
+        for (auto* terms : { &px, &py, &pz, &qx, &qy, &qz, &rx, &ry, &rz }) terms->resize(count);
+        Vec3 u, v, w;
+        camera.getCameraBasis(u, v, w);
+        for (int i = 0; i < count; ++i) {
+            Vec3 p, q, r;
+            camera.columnTerms(x0 + i + 0.5, u, v, w, p, q, r);
+            px[i] = p.x, py[i] = p.y, pz[i] = p.z;
+            qx[i] = q.x, qy[i] = q.y, qz[i] = q.z;
+            rx[i] = r.x, ry[i] = r.y, rz[i] = r.z;
+        }
+    }
+
+    // directions[i] é a direção normalizada do centro do pixel (x0 + i, y)
+    void row(int y, std::vector<Vec3>& directions) const {
+        directions.resize(count);
+        double scale, t;
+        camera.rowTerms(y + 0.5, scale, t);
+        int i = 0;
+#ifdef CAMERA_SSE2
+        __m128d vscale = _mm_set1_pd(scale), vt = _mm_set1_pd(t);
+        for (; i + 2 <= count; i += 2) {
+            __m128d dx = combine(&px[i], &qx[i], &rx[i], vscale, vt);
+            __m128d dy = combine(&py[i], &qy[i], &ry[i], vscale, vt);
+            __m128d dz = combine(&pz[i], &qz[i], &rz[i], vscale, vt);
+            __m128d length = _mm_sqrt_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)), _mm_mul_pd(dz, dz)));
+            dx = _mm_div_pd(dx, length);
+            dy = _mm_div_pd(dy, length);
+            dz = _mm_div_pd(dz, length);
+            _mm_storel_pd(&directions[i].x, dx);
+            _mm_storel_pd(&directions[i].y, dy);
+            _mm_storel_pd(&directions[i].z, dz);
+            _mm_storeh_pd(&directions[i + 1].x, dx);
+            _mm_storeh_pd(&directions[i + 1].y, dy);
+            _mm_storeh_pd(&directions[i + 1].z, dz);
+        }
+#endif
+        for (; i < count; ++i) {
+            Vec3 p(px[i], py[i], pz[i]), q(qx[i], qy[i], qz[i]), r(rx[i], ry[i], rz[i]);
+            directions[i] = (p * scale + q * t + r).normalize();
+        }
+    }
+
+private:
+    const Camera& camera;
+    int count;
+    std::vector<double> px, py, pz, qx, qy, qz, rx, ry, rz;
+
+#ifdef CAMERA_SSE2
+    static __m128d combine(const double* p, const double* q, const double* r, __m128d scale, __m128d t) {
+        return _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_loadu_pd(p), scale), _mm_mul_pd(_mm_loadu_pd(q), t)), _mm_loadu_pd(r));
     }
+#endif
 };
 
 #endif // CAMERA_H
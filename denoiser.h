@@ -0,0 +1,237 @@
+#ifndef DENOISER_H
+#define DENOISER_H
+
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include "vec3.h"
+#include "thread_pool.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define DENOISER_SSE2
+#endif
+
+// Buffers auxiliares do raio primário de cada pixel, em layout SoA para vetorização
+class GBuffer {
+public:
+    int width, height;
+    std::vector<float> normalX, normalY, normalZ;
+    std::vector<float> depth;
+    std::vector<float> albedoR, albedoG, albedoB;
+    std::vector<int> id;
+
+    GBuffer(int w, int h)
+        : width(w), height(h), normalX(w * h), normalY(w * h), normalZ(w * h), depth(w * h),
+          albedoR(w * h), albedoG(w * h), albedoB(w * h), id(w * h, -1) {}
+
+    void set(int x, int y, const Vec3& normal, double d, const Vec3& albedo, int primitiveId) {
+        int i = y * width + x;
+        normalX[i] = float(normal.x);
+        normalY[i] = float(normal.y);
+        normalZ[i] = float(normal.z);
+        depth[i] = float(d);
+        albedoR[i] = float(albedo.x);
+        albedoG[i] = float(albedo.y);
+        albedoB[i] = float(albedo.z);
+        id[i] = primitiveId;
+    }
+};
+
+class DenoiseSettings {
+public:
+    int passes = 5;               // passo do filtro dobra a cada passada: 1, 2, 4, 8, 16
+    float sigmaColor = 0.6f;      // tolerância de cor na primeira passada, reduzida à metade a cada passada
+    float sigmaDepth = 0.5f;      // diferença de profundidade tolerada por unidade de passo
+    int normalPower = 5;          // peso da normal = max(0, n.n')^(2^normalPower)
+    bool demodulateAlbedo = true; // filtra apenas a iluminação, preservando texturas e cores das primitivas
+};
+
+// Filtro à-trous com bordas preservadas (Dammertz et al. 2010): kernel B3-spline 5x5 com
+// buracos crescentes, ponderado pelas diferenças de cor, normal, profundidade e ID da primitiva.
+class AtrousDenoiser {
+public:
+    DenoiseSettings settings;
+    double lastMilliseconds = 0.0;
+    double lastMillisecondsPerMegapixel = 0.0;
+
+    explicit AtrousDenoiser(const DenoiseSettings& s) : settings(s) {}
+
+    // Com pool, as faixas de linhas de cada passada viram tarefas dele; sem pool, tudo na thread atual
+    void denoise(std::vector<Vec3>& colors, const GBuffer& gbuffer, ThreadPool* pool = nullptr) {
+        auto start = std::chrono::steady_clock::now();
+        const int n = gbuffer.width * gbuffer.height;
+        std::vector<float> r(n), g(n), b(n), outR(n), outG(n), outB(n);
+
+        for (int i = 0; i < n; ++i) {
+            Vec3 c = colors[i];
+            if (settings.demodulateAlbedo) c = Vec3(demodulate(c.x, gbuffer.albedoR[i]), demodulate(c.y, gbuffer.albedoG[i]),
+                                                    demodulate(c.z, gbuffer.albedoB[i]));
+            r[i] = float(c.x);
+            g[i] = float(c.y);
+            b[i] = float(c.z);
+        }
+
+        const int rowsPerBand = 16;
+        int bands = (gbuffer.height + rowsPerBand - 1) / rowsPerBand;
+        float sigmaColor = settings.sigmaColor;
+        for (int pass = 0; pass < settings.passes; ++pass) {
+            int step = 1 << pass;
+            float invSigmaColor2 = 1.0f / (sigmaColor * sigmaColor);
+            // Faixas de linhas independentes: cada uma lê o buffer de entrada inteiro e escreve só as suas linhas
+            auto band = [&](int i) {
+                int y0 = i * rowsPerBand, y1 = std::min(gbuffer.height, y0 + rowsPerBand);
+                filterRows(gbuffer, step, invSigmaColor2, y0, y1, r.data(), g.data(), b.data(), outR.data(), outG.data(), outB.data());
+            };
+            if (pool && bands > 1) pool->parallelFor(bands, band);
+            else for (int i = 0; i < bands; ++i) band(i);
+            r.swap(outR);
+            g.swap(outG);
+            b.swap(outB);
+            sigmaColor *= 0.5f;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            Vec3 c(r[i], g[i], b[i]);
+            if (settings.demodulateAlbedo) c = Vec3(c.x * albedoFactor(gbuffer.albedoR[i]), c.y * albedoFactor(gbuffer.albedoG[i]),
+                                                    c.z * albedoFactor(gbuffer.albedoB[i]));
+            colors[i] = c;
+        }
+
+        lastMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        lastMillisecondsPerMegapixel = n > 0 ? lastMilliseconds / (n / 1e6) : 0.0;
+    }
+
+private:
+    static constexpr float ALBEDO_EPSILON = 0.01f;
+
+    static float albedoFactor(float albedo) {
+        return std::max(albedo, ALBEDO_EPSILON);
+    }
+
+    static double demodulate(double color, float albedo) {
+        return color / albedoFactor(albedo);
+    }
+
+    // Aproximação de exp(-x) para x >= 0 sem chamadas de biblioteca, vetorizável
+    static float negExp(float x) {
+        return 1.0f / (1.0f + x * (1.0f + x * (0.5f + x * (1.0f / 6.0f + x * (1.0f / 24.0f)))));
+    }
+
+    float normalWeight(float dot) const {
+        float w = std::max(dot, 0.0f);
+        for (int i = 0; i < settings.normalPower; ++i) w *= w;
+        return w;
+    }
+
+    void filterRows(const GBuffer& gb, int step, float invSigmaColor2, int y0, int y1,
+                    const float* r, const float* g, const float* b, float* outR, float* outG, float* outB) const {
+        static const float kernel[5] = { 1.0f / 16, 1.0f / 4, 3.0f / 8, 1.0f / 4, 1.0f / 16 };
+        const int width = gb.width;
+        const float invSigmaDepth = 1.0f / (settings.sigmaDepth * step);
+        std::vector<float> sumR(width), sumG(width), sumB(width), sumW(width);
+
+        for (int y = y0; y < y1; ++y) {
+            const int row = y * width;
+            const float centerWeight = kernel[2] * kernel[2];
+            for (int x = 0; x < width; ++x) {
+                sumR[x] = centerWeight * r[row + x];
+                sumG[x] = centerWeight * g[row + x];
+                sumB[x] = centerWeight * b[row + x];
+                sumW[x] = centerWeight;
+            }
+
+            for (int ky = 0; ky < 5; ++ky) {
+                int yy = y + (ky - 2) * step;
+                if (yy < 0 || yy >= gb.height) continue;
+                for (int kx = 0; kx < 5; ++kx) {
+                    if (kx == 2 && ky == 2) continue;
+                    int offset = (kx - 2) * step;
+                    int xStart = std::max(0, -offset);
+                    int xEnd = std::min(width, width - offset);
+                    if (xStart >= xEnd) continue;
+                    TapRange tap = { row, yy * width + offset, xStart, xEnd, kernel[kx] * kernel[ky] };
+                    accumulateTap(gb, tap, invSigmaColor2, invSigmaDepth, r, g, b,
+                                  sumR.data(), sumG.data(), sumB.data(), sumW.data());
+                }
+            }
+
+            for (int x = 0; x < width; ++x) {
+                float inv = 1.0f / sumW[x];
+                outR[row + x] = sumR[x] * inv;
+                outG[row + x] = sumG[x] * inv;
+                outB[row + x] = sumB[x] * inv;
+            }
+        }
+    }
+
+    struct TapRange {
+        int center;     // índice do início da linha central
+        int neighbor;   // índice do vizinho de x = 0 (linha vizinha + deslocamento horizontal)
+        int xStart, xEnd;
+        float kernel;
+    };
+
+    void accumulateTap(const GBuffer& gb, const TapRange& tap, float invSigmaColor2, float invSigmaDepth,
+                       const float* r, const float* g, const float* b,
+                       float* sumR, float* sumG, float* sumB, float* sumW) const {
+        int x = tap.xStart;
+#ifdef DENOISER_SSE2
+        const __m128 one = _mm_set1_ps(1.0f), half = _mm_set1_ps(0.5f), sixth = _mm_set1_ps(1.0f / 6.0f);
+        const __m128 twentyFourth = _mm_set1_ps(1.0f / 24.0f), zero = _mm_setzero_ps();
+        const __m128 kernel = _mm_set1_ps(tap.kernel);
+        const __m128 sigmaC = _mm_set1_ps(invSigmaColor2), sigmaZ = _mm_set1_ps(invSigmaDepth);
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        auto negExp4 = [&](__m128 v) {
+            __m128 p = _mm_add_ps(sixth, _mm_mul_ps(v, twentyFourth));
+            p = _mm_add_ps(half, _mm_mul_ps(v, p));
+            p = _mm_add_ps(one, _mm_mul_ps(v, p));
+            p = _mm_add_ps(one, _mm_mul_ps(v, p));
+            return _mm_div_ps(one, p);
+        };
+        for (; x + 4 <= tap.xEnd; x += 4) {
+            int c = tap.center + x, q = tap.neighbor + x;
+            __m128 cr = _mm_loadu_ps(r + c), cg = _mm_loadu_ps(g + c), cb = _mm_loadu_ps(b + c);
+            __m128 qr = _mm_loadu_ps(r + q), qg = _mm_loadu_ps(g + q), qb = _mm_loadu_ps(b + q);
+            __m128 dr = _mm_sub_ps(cr, qr), dg = _mm_sub_ps(cg, qg), db = _mm_sub_ps(cb, qb);
+            __m128 colorDist = _mm_add_ps(_mm_mul_ps(dr, dr), _mm_add_ps(_mm_mul_ps(dg, dg), _mm_mul_ps(db, db)));
+
+            __m128 dot = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&gb.normalX[c]), _mm_loadu_ps(&gb.normalX[q])),
+                         _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&gb.normalY[c]), _mm_loadu_ps(&gb.normalY[q])),
+                                    _mm_mul_ps(_mm_loadu_ps(&gb.normalZ[c]), _mm_loadu_ps(&gb.normalZ[q]))));
+            __m128 wn = _mm_max_ps(dot, zero);
+            for (int i = 0; i < settings.normalPower; ++i) wn = _mm_mul_ps(wn, wn);
+            // Fundo (ID -1) não tem normal: pixels com o mesmo ID no fundo usam peso de normal 1
+            __m128i cid = _mm_loadu_si128((const __m128i*)&gb.id[c]);
+            __m128i qid = _mm_loadu_si128((const __m128i*)&gb.id[q]);
+            __m128 sameId = _mm_castsi128_ps(_mm_cmpeq_epi32(cid, qid));
+            __m128 background = _mm_castsi128_ps(_mm_cmplt_epi32(cid, _mm_setzero_si128()));
+            wn = _mm_or_ps(_mm_and_ps(background, one), _mm_andnot_ps(background, wn));
+
+            __m128 dz = _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(&gb.depth[c]), _mm_loadu_ps(&gb.depth[q])), absMask);
+            __m128 w = _mm_mul_ps(negExp4(_mm_mul_ps(colorDist, sigmaC)), negExp4(_mm_mul_ps(dz, sigmaZ)));
+            w = _mm_and_ps(_mm_mul_ps(_mm_mul_ps(w, wn), kernel), sameId);
+
+            _mm_storeu_ps(sumR + x, _mm_add_ps(_mm_loadu_ps(sumR + x), _mm_mul_ps(w, qr)));
+            _mm_storeu_ps(sumG + x, _mm_add_ps(_mm_loadu_ps(sumG + x), _mm_mul_ps(w, qg)));
+            _mm_storeu_ps(sumB + x, _mm_add_ps(_mm_loadu_ps(sumB + x), _mm_mul_ps(w, qb)));
+            _mm_storeu_ps(sumW + x, _mm_add_ps(_mm_loadu_ps(sumW + x), w));
+        }
+#endif
+        for (; x < tap.xEnd; ++x) {
+            int c = tap.center + x, q = tap.neighbor + x;
+            if (gb.id[c] != gb.id[q]) continue;
+            float dr = r[c] - r[q], dg = g[c] - g[q], db = b[c] - b[q];
+            float wn = gb.id[c] < 0 ? 1.0f : normalWeight(gb.normalX[c] * gb.normalX[q] + gb.normalY[c] * gb.normalY[q] +
+                                                          gb.normalZ[c] * gb.normalZ[q]);
+            float dz = std::fabs(gb.depth[c] - gb.depth[q]);
+            float w = tap.kernel * wn * negExp((dr * dr + dg * dg + db * db) * invSigmaColor2) * negExp(dz * invSigmaDepth);
+            sumR[x] += w * r[q];
+            sumG[x] += w * g[q];
+            sumB[x] += w * b[q];
+            sumW[x] += w;
+        }
+    }
+};
+
+#endif // DENOISER_H
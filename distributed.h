@@ -0,0 +1,363 @@
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+// Renderização distribuída por tiles entre processos worker (somente POSIX)
+#ifndef _WIN32
+
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <functional>
+#include <thread>
+#include <signal.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "tile.h"
+
+// Renderiza o tile e devolve os pixels RGBA8 do bloco, linha a linha
+typedef std::function<void(const Tile&, std::vector<unsigned char>&)> TileRenderFn;
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace net {
+
+// Mensagens em ordem de bytes nativa: coordenador e workers rodam no mesmo tipo de máquina
+const uint32_t TILE_REQUEST = 0x454c4954; // "TILE"
+const uint32_t TILE_RESULT = 0x4c584950;  // "PIXL"
+const uint32_t SHUTDOWN = 0x54495551;     // "QUIT"
+
+struct TileHeader {
+    uint32_t type;
+    uint32_t tileId;
+    int32_t x0, y0, x1, y1;
+};
+
+inline bool writeAll(int fd, const void* data, size_t size) {
+    const char* p = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= size_t(n);
+    }
+    return true;
+}
+
+inline bool readAll(int fd, void* data, size_t size) {
+    char* p = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t n = recv(fd, p, size, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= size_t(n);
+    }
+    return true;
+}
+
+// Um worker que para no meio de uma mensagem não pode travar o coordenador
+inline void setReceiveTimeout(int fd, int milliseconds) {
+    timeval tv;
+    tv.tv_sec = milliseconds / 1000;
+    tv.tv_usec = (milliseconds % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+}
+
+// Um cliente que para de ler a resposta não pode prender quem escreve
+inline void setSendTimeout(int fd, int milliseconds) {
+    timeval tv;
+    tv.tv_sec = milliseconds / 1000;
+    tv.tv_usec = (milliseconds % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+inline int connectTcp(const std::string& host, int port) {
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0) return -1;
+    int fd = -1;
+    for (addrinfo* a = result; a; a = a->ai_next) {
+        fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd < 0) continue;
+        if (connect(fd, a->ai_addr, a->ai_addrlen) == 0) break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(result);
+    if (fd >= 0) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return fd;
+}
+
+inline int listenTcp(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(uint16_t(port));
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 16) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+} // namespace net
+
+// Laço do worker: responde a pedidos de tile até receber SHUTDOWN ou a conexão fechar
+inline void runTileWorker(int fd, const TileRenderFn& renderTile) {
+    std::vector<unsigned char> pixels;
+    net::TileHeader header;
+    while (net::readAll(fd, &header, sizeof(header)) && header.type == net::TILE_REQUEST) {
+        Tile tile(header.x0, header.y0, header.x1, header.y1);
+        pixels.assign(size_t(tile.x1 - tile.x0) * (tile.y1 - tile.y0) * 4, 0);
+        renderTile(tile, pixels);
+        header.type = net::TILE_RESULT;
+        if (!net::writeAll(fd, &header, sizeof(header)) || !net::writeAll(fd, pixels.data(), pixels.size())) break;
+    }
+}
+
+// Worker TCP: atende um coordenador por vez na porta dada
+inline int serveTileWorker(int port, const TileRenderFn& renderTile) {
+    int listenFd = net::listenTcp(port);
+    if (listenFd < 0) return -1;
+    for (;;) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        runTileWorker(fd, renderTile);
+        close(fd);
+    }
+    close(listenFd);
+    return 0;
+}
+
+class LocalWorkers {
+public:
+    std::vector<int> fds;
+    std::vector<pid_t> pids;
+    int shutdownGraceMs = 1000;  // tempo para um filho sair depois do QUIT antes de levar SIGKILL
+
+    // Cria workers com fork(): os filhos herdam a cena já carregada e conversam por socketpair Unix
+    LocalWorkers(int count, const TileRenderFn& renderTile) {
+        for (int i = 0; i < count; ++i) {
+            int pair[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) break;
+            pid_t pid = fork();
+            if (pid == 0) {
+                close(pair[0]);
+                for (int fd : fds) close(fd);
+                runTileWorker(pair[1], renderTile);
+                close(pair[1]);
+                _exit(0);
+            }
+            close(pair[1]);
+            if (pid < 0) {
+                close(pair[0]);
+                break;
+            }
+            fds.push_back(pair[0]);
+            pids.push_back(pid);
+        }
+    }
+
+    // Worker abandonado pelo coordenador: pode estar preso num tile e nunca ler o QUIT
+    void abandon(int fd) {
+        for (size_t i = 0; i < fds.size(); ++i) {
+            if (fds[i] == fd && pids[i] > 0) kill(pids[i], SIGKILL);
+        }
+    }
+
+    // QUIT para todos; quem não sair dentro de shutdownGraceMs é morto antes do waitpid
+    ~LocalWorkers() {
+        net::TileHeader quit = { net::SHUTDOWN, 0, 0, 0, 0, 0 };
+        for (int fd : fds) {
+            net::writeAll(fd, &quit, sizeof(quit));
+            close(fd);
+        }
+        std::vector<char> reaped(pids.size(), 0);
+        size_t remaining = pids.size();
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(shutdownGraceMs);
+        while (remaining > 0 && std::chrono::steady_clock::now() < deadline) {
+            for (size_t i = 0; i < pids.size(); ++i) {
+                if (!reaped[i] && waitpid(pids[i], nullptr, WNOHANG) != 0) {
+                    reaped[i] = 1;
+                    --remaining;
+                }
+            }
+            if (remaining > 0) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        for (size_t i = 0; i < pids.size(); ++i) {
+            if (reaped[i]) continue;
+            kill(pids[i], SIGKILL);
+            waitpid(pids[i], nullptr, 0);
+        }
+    }
+};
+
+class TileCoordinator {
+public:
+    int tileSize = 32;
+    int tileTimeoutMs = 5000;  // depois disso o tile é reemitido para outro worker
+    int reissuedTiles = 0;
+    int deadWorkers = 0;
+    std::vector<int> deadFds;  // conexões abandonadas; workers locais nelas devem ser mortos
+
+    // fds: conexões já abertas com workers (socketpair local ou TCP). Não são fechadas aqui.
+    // fallback renderiza localmente os tiles que sobrarem se todos os workers morrerem.
+    void render(const std::vector<int>& fds, int width, int height, const TileRenderFn& fallback,
+                std::vector<unsigned char>& image) {
+        typedef std::chrono::steady_clock Clock;
+        std::vector<Tile> tiles = makeTiles(width, height, tileSize);
+        std::vector<char> done(tiles.size(), 0);
+        std::deque<int> pending;
+        for (size_t i = 0; i < tiles.size(); ++i) pending.push_back(int(i));
+        size_t remaining = tiles.size();
+
+        struct WorkerState {
+            int fd;
+            bool alive;
+            int tile;                 // -1 quando ocioso
+            Clock::time_point issued;
+            bool reissued;            // o tile atual já voltou para a fila uma vez
+        };
+        std::vector<WorkerState> workers;
+        for (int fd : fds) {
+            net::setReceiveTimeout(fd, tileTimeoutMs);
+            workers.push_back(WorkerState{ fd, true, -1, Clock::now(), false });
+        }
+
+        std::vector<unsigned char> pixels;
+        while (remaining > 0) {
+            // Tiles de workers lentos voltam para a fila uma vez por atribuição; o primeiro resultado que
+            // chegar vence. Um worker que passa de 4x o limite é abandonado como morto.
+            Clock::time_point now = Clock::now();
+            for (auto& w : workers) {
+                if (!w.alive || w.tile < 0 || done[w.tile]) continue;
+                long long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - w.issued).count();
+                if (elapsed > 4LL * tileTimeoutMs) {
+                    markDead(w.fd, w.alive, w.tile, pending, done);
+                } else if (elapsed > tileTimeoutMs && !w.reissued) {
+                    w.reissued = true;
+                    if (std::find(pending.begin(), pending.end(), w.tile) == pending.end()) {
+                        pending.push_front(w.tile);
+                        ++reissuedTiles;
+                    }
+                }
+            }
+
+            for (auto& w : workers) {
+                if (!w.alive || w.tile >= 0) continue;
+                while (!pending.empty() && done[pending.front()]) pending.pop_front();
+                if (pending.empty()) break;
+                int t = pending.front();
+                pending.pop_front();
+                net::TileHeader request = { net::TILE_REQUEST, uint32_t(t), tiles[t].x0, tiles[t].y0, tiles[t].x1, tiles[t].y1 };
+                if (!net::writeAll(w.fd, &request, sizeof(request))) {
+                    markDead(w.fd, w.alive, t, pending, done);
+                    continue;
+                }
+                w.tile = t;
+                w.issued = Clock::now();
+                w.reissued = false;
+            }
+
+            std::vector<pollfd> polls;
+            std::vector<WorkerState*> polled;
+            for (auto& w : workers) {
+                if (!w.alive || w.tile < 0) continue;
+                polls.push_back(pollfd{ w.fd, POLLIN, 0 });
+                polled.push_back(&w);
+            }
+
+            if (polls.empty()) {
+                // Nenhum worker vivo: termina localmente
+                for (int t : pending) {
+                    if (done[t]) continue;
+                    renderTileInto(fallback, tiles[t], width, image, pixels);
+                    done[t] = 1;
+                    --remaining;
+                }
+                pending.clear();
+                continue;
+            }
+
+            if (poll(polls.data(), polls.size(), 100) <= 0) continue;
+            for (size_t i = 0; i < polls.size(); ++i) {
+                if (!polls[i].revents) continue;
+                WorkerState& w = *polled[i];
+                net::TileHeader result;
+                bool ok = net::readAll(w.fd, &result, sizeof(result)) && result.type == net::TILE_RESULT &&
+                          result.tileId < tiles.size();
+                if (ok) {
+                    const Tile& tile = tiles[result.tileId];
+                    pixels.resize(size_t(tile.x1 - tile.x0) * (tile.y1 - tile.y0) * 4);
+                    ok = net::readAll(w.fd, pixels.data(), pixels.size());
+                    if (ok && !done[result.tileId]) {
+                        copyTile(tile, pixels, width, image);
+                        done[result.tileId] = 1;
+                        --remaining;
+                    }
+                }
+                if (!ok) {
+                    markDead(w.fd, w.alive, w.tile, pending, done);
+                    continue;
+                }
+                w.tile = -1;
+            }
+        }
+    }
+
+private:
+    void markDead(int fd, bool& alive, int tile, std::deque<int>& pending, const std::vector<char>& done) {
+        alive = false;
+        ++deadWorkers;
+        deadFds.push_back(fd);
+        if (tile >= 0 && !done[tile] && std::find(pending.begin(), pending.end(), tile) == pending.end()) {
+            pending.push_front(tile);
+        }
+    }
+
+    static void copyTile(const Tile& tile, const std::vector<unsigned char>& pixels, int width, std::vector<unsigned char>& image) {
+        size_t rowBytes = size_t(tile.x1 - tile.x0) * 4;
+        for (int y = tile.y0; y < tile.y1; ++y) {
+            std::memcpy(&image[(size_t(y) * width + tile.x0) * 4], &pixels[(y - tile.y0) * rowBytes], rowBytes);
+        }
+    }
+
+    static void renderTileInto(const TileRenderFn& fn, const Tile& tile, int width, std::vector<unsigned char>& image,
+                               std::vector<unsigned char>& pixels) {
+        pixels.assign(size_t(tile.x1 - tile.x0) * (tile.y1 - tile.y0) * 4, 0);
+        fn(tile, pixels);
+        copyTile(tile, pixels, width, image);
+    }
+};
+
+#endif // _WIN32
+
+#endif // DISTRIBUTED_H
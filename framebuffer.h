@@ -0,0 +1,202 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include "vec3.h"
+#include "thread_pool.h"
+#include "png_memory.h"
+#include "qoi.h"
+#include "lodepng.h"
+
+inline unsigned char toByte(double value) {
+    return static_cast<unsigned char>(std::min(std::max(value, 0.0), 1.0) * 255);
+}
+
+// Converte cores em ponto flutuante para o buffer RGBA de 8 bits usado pelos encoders
+inline void resolveColors(const std::vector<Vec3>& colors, std::vector<unsigned char>& image) {
+    for (size_t i = 0; i < colors.size(); ++i) {
+        image[4 * i + 0] = toByte(colors[i].x);
+        image[4 * i + 1] = toByte(colors[i].y);
+        image[4 * i + 2] = toByte(colors[i].z);
+        image[4 * i + 3] = 255;
+    }
+}
+
+// PPM texto (P3) a partir do buffer RGBA8; o canal alfa é descartado
+inline void encodePPM(const std::vector<unsigned char>& image, int width, int height, std::string& out) {
+    out = "P3\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+    out.reserve(out.size() + size_t(width) * height * 12);
+    for (size_t i = 0; i < size_t(width) * height; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            out += std::to_string(int(image[4 * i + c]));
+            out += c < 2 ? ' ' : '\n';
+        }
+    }
+}
+
+// Nomes dos presets de compressão do PNG, do mais rápido ao menor arquivo
+inline bool parseCompressionPreset(const std::string& name, LodePNGCompressionPreset& preset) {
+    static const char* const names[] = { "store", "huffman", "rle", "fast", "default", "max" };
+    for (int i = 0; i < 6; ++i) {
+        if (name == names[i]) {
+            preset = LodePNGCompressionPreset(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// parallel_for do lodepng no pool: as faixas de linhas da filtragem viram tarefas
+inline void lodepngParallelFor(void (*task)(void*, unsigned), void* context, unsigned count, const void* pool) {
+    static_cast<ThreadPool*>(const_cast<void*>(pool))->parallelFor(int(count), [&](int i) { task(context, unsigned(i)); });
+}
+
+// Estado do lodepng para o buffer RGBA8 do renderizador, com o preset de compressão dado. Com pool,
+// a escolha de filtro das linhas roda em paralelo; o arquivo sai idêntico.
+// O renderizador sempre grava alfa 255, então o PNG é RGB de 8 bits declarado de antemão: sem a
+// varredura de cores do auto_convert, e o lodepng descarta o alfa linha a linha durante a filtragem.
+inline void setupPNGState(lodepng::State& state, LodePNGCompressionPreset preset, ThreadPool* pool) {
+    lodepng_encoder_settings_preset(&state.encoder, preset);
+    state.encoder.auto_convert = 0;
+    state.info_png.color.colortype = LCT_RGB;
+    state.info_png.color.bitdepth = 8;
+    if (pool) {
+        state.encoder.parallel_for = lodepngParallelFor;
+        state.encoder.parallel_context = pool;
+    }
+}
+
+// PNG em memória a partir do buffer RGBA8. Com memory, o lodepng aloca do pool de memória da thread.
+inline unsigned encodePNG(const std::vector<unsigned char>& image, int width, int height, std::vector<unsigned char>& png,
+                          LodePNGCompressionPreset preset = LCP_DEFAULT, ThreadPool* pool = nullptr,
+                          PNGMemoryPool* memory = nullptr) {
+    PNGAllocatorScope scope(memory);
+    lodepng::State state;
+    setupPNGState(state, preset, pool);
+    return lodepng::encode(png, image, width, height, state);
+}
+
+inline bool hasExtension(const std::string& path, const char* extension) {
+    size_t length = std::strlen(extension);
+    return path.size() >= length && path.compare(path.size() - length, length, extension) == 0;
+}
+
+// Codifica e grava de uma vez: PPM ou QOI pela extensão do caminho, PNG nos demais casos.
+// Sem mensagens de progresso, para uso nas threads de animação e lotes de câmeras. O PNG vai para o
+// arquivo um bloco de deflate por vez, sem o arquivo inteiro na memória; com memory, codificar não
+// aloca nada depois da primeira imagem.
+inline bool writeImageFile(const std::string& path, const std::vector<unsigned char>& image, int width, int height,
+                           LodePNGCompressionPreset preset = LCP_DEFAULT, ThreadPool* pool = nullptr,
+                           PNGMemoryPool* memory = nullptr) {
+    bool ok;
+    if (hasExtension(path, ".ppm") || hasExtension(path, ".qoi")) {
+        std::string ppm;
+        std::vector<unsigned char> qoi;
+        const void* data;
+        size_t size;
+        if (hasExtension(path, ".ppm")) {
+            encodePPM(image, width, height, ppm);
+            data = ppm.data();
+            size = ppm.size();
+        } else {
+            encodeQOI(image, width, height, qoi, pool);
+            data = qoi.data();
+            size = qoi.size();
+        }
+        FILE* file = std::fopen(path.c_str(), "wb");
+        ok = file && std::fwrite(data, 1, size, file) == size;
+        if (file) ok = std::fclose(file) == 0 && ok;
+    } else {
+        PNGAllocatorScope scope(memory);
+        lodepng::State state;
+        setupPNGState(state, preset, pool);
+        unsigned error = lodepng::encode(path, image.data(), width, height, state);
+        if (error && error != 79 && error != 116) {
+            std::cout << "Encoder error " << error << ": " << lodepng_error_text(error) << std::endl;
+            return false;
+        }
+        ok = error == 0;
+    }
+    if (!ok) std::cout << "Erro ao gravar " << path << std::endl;
+    return ok;
+}
+
+namespace pattern {
+
+// Conversão do número em pattern a partir de '%' em start: %d, %i ou com largura, ex. %04d.
+// Devolve o tamanho da conversão ou 0 se não for uma.
+inline size_t numberConversion(const std::string& pattern, size_t start, bool& zeroPad, int& width) {
+    size_t i = start + 1;
+    zeroPad = i < pattern.size() && pattern[i] == '0';
+    if (zeroPad) ++i;
+    width = 0;
+    size_t digits = 0;
+    while (i < pattern.size() && pattern[i] >= '0' && pattern[i] <= '9' && digits < 2) {
+        width = width * 10 + (pattern[i++] - '0');
+        ++digits;
+    }
+    if (i < pattern.size() && (pattern[i] == 'd' || pattern[i] == 'i')) return i + 1 - start;
+    return 0;
+}
+
+} // namespace pattern
+
+// Padrão de uma sequência de arquivos: exatamente um %d (com largura opcional, ex. %04d) e %% para
+// um '%' literal. Qualquer outra conversão do printf é recusada.
+inline bool isNumberedPattern(const std::string& text) {
+    int conversions = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] != '%') continue;
+        if (i + 1 < text.size() && text[i + 1] == '%') {
+            ++i;
+            continue;
+        }
+        bool zeroPad;
+        int width;
+        size_t length = pattern::numberConversion(text, i, zeroPad, width);
+        if (length == 0) return false;
+        ++conversions;
+        i += length - 1;
+    }
+    return conversions == 1;
+}
+
+// Caminho de saída de uma sequência: o padrão com o número da imagem no lugar do %d, ex.
+// frame_%04d.png. O número é escrito aqui, sem passar o padrão do usuário ao printf; partes que não
+// formam uma conversão válida ficam como estão.
+inline std::string numberedPath(const std::string& text, int index) {
+    std::string path;
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] != '%') {
+            path += text[i];
+            continue;
+        }
+        if (i + 1 < text.size() && text[i + 1] == '%') {
+            path += '%';
+            ++i;
+            continue;
+        }
+        bool zeroPad;
+        int width;
+        size_t length = pattern::numberConversion(text, i, zeroPad, width);
+        if (length == 0) {
+            path += '%';
+            continue;
+        }
+        std::string number = std::to_string(index < 0 ? -static_cast<long long>(index) : index);
+        int padding = width - int(number.size()) - (index < 0 ? 1 : 0);
+        if (!zeroPad && padding > 0) path.append(size_t(padding), ' ');
+        if (index < 0) path += '-';
+        if (zeroPad && padding > 0) path.append(size_t(padding), '0');
+        path += number;
+        i += length - 1;
+    }
+    return path;
+}
+
+#endif // FRAMEBUFFER_H
@@ -0,0 +1,199 @@
+#ifndef HDR_H
+#define HDR_H
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include "thread_pool.h"
+#include "framebuffer.h"
+#include "lodepng.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define HDR_SSE2
+#endif
+
+// Saída do framebuffer HDR (RGB float por pixel, sem clamp, ver renderImageHDR): PFM com os valores
+// lineares e, com exposição e tone mapping, RGBA8 para os encoders ou RGB de 16 bits para o PNG.
+// Exposição, curva, clamp e quantização são uma única passada pelo framebuffer.
+
+enum class ToneMap {
+    Clamp,     // valores acima de 1 saturam, como no caminho de 8 bits
+    Reinhard,  // x / (1 + x) por canal
+    ACES       // ajuste de Narkowicz da curva filmic do ACES
+};
+
+class ToneMapSettings {
+public:
+    ToneMap curve = ToneMap::Clamp;
+    double exposure = 0;  // em stops: as cores são multiplicadas por 2^exposure antes da curva
+};
+
+inline bool parseToneMap(const std::string& name, ToneMap& curve) {
+    if (name == "clamp") curve = ToneMap::Clamp;
+    else if (name == "reinhard") curve = ToneMap::Reinhard;
+    else if (name == "aces") curve = ToneMap::ACES;
+    else return false;
+    return true;
+}
+
+namespace hdr {
+
+// Curva em [0, 1], NaN vira 0; a versão SSE2 abaixo calcula o mesmo
+inline float toneMap(float value, float scale, ToneMap curve) {
+    float x = value * scale;
+    x = x > 0 ? x : 0;
+    if (curve == ToneMap::Reinhard) x = x / (1 + x);
+    else if (curve == ToneMap::ACES) x = (x * (2.51f * x + 0.03f)) / (x * (2.43f * x + 0.59f) + 0.14f);
+    return x < 1 ? x : 1;
+}
+
+#ifdef HDR_SSE2
+inline __m128 toneMap(__m128 value, __m128 scale, ToneMap curve) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128 x = _mm_max_ps(_mm_mul_ps(value, scale), _mm_setzero_ps());
+    if (curve == ToneMap::Reinhard) {
+        x = _mm_div_ps(x, _mm_add_ps(one, x));
+    } else if (curve == ToneMap::ACES) {
+        __m128 numerator = _mm_mul_ps(x, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.51f), x), _mm_set1_ps(0.03f)));
+        __m128 denominator = _mm_add_ps(_mm_mul_ps(x, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.43f), x), _mm_set1_ps(0.59f))),
+                                        _mm_set1_ps(0.14f));
+        x = _mm_div_ps(numerator, denominator);
+    }
+    return _mm_min_ps(x, one);
+}
+#endif
+
+inline void toRGBA8Portable(const float* in, size_t count, float scale, ToneMap curve, unsigned char* out) {
+    for (size_t i = 0; i < count; ++i) {
+        for (int c = 0; c < 3; ++c) out[4 * i + c] = static_cast<unsigned char>(toneMap(in[3 * i + c], scale, curve) * 255);
+        out[4 * i + 3] = 255;
+    }
+}
+
+inline void toRGB16Portable(const float* in, size_t count, float scale, ToneMap curve, unsigned char* out) {
+    for (size_t i = 0; i < 3 * count; ++i) {
+        unsigned value = unsigned(toneMap(in[i], scale, curve) * 65535 + 0.5f);
+        out[2 * i + 0] = static_cast<unsigned char>(value >> 8);
+        out[2 * i + 1] = static_cast<unsigned char>(value);
+    }
+}
+
+// count pixels RGB float para RGBA8. Trunca como toByte, então a curva Clamp sem exposição dá o
+// mesmo byte que o caminho de 8 bits.
+inline void toRGBA8(const float* in, size_t count, float scale, ToneMap curve, unsigned char* out) {
+    size_t i = 0;
+#ifdef HDR_SSE2
+    // 4 pixels por vez: os 12 floats viram um vetor por pixel, com o alfa na quarta posição
+    const __m128 vscale = _mm_set1_ps(scale), v255 = _mm_set1_ps(255.0f);
+    const __m128i rgbMask = _mm_set_epi32(0, -1, -1, -1), alpha = _mm_set_epi32(255, 0, 0, 0);
+    for (; i + 4 <= count; i += 4) {
+        __m128 v0 = _mm_loadu_ps(in + 3 * i), v1 = _mm_loadu_ps(in + 3 * i + 4), v2 = _mm_loadu_ps(in + 3 * i + 8);
+        __m128 pixel[4];
+        pixel[0] = v0;
+        pixel[1] = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(1, 0, 3, 3));
+        pixel[1] = _mm_shuffle_ps(pixel[1], pixel[1], _MM_SHUFFLE(0, 3, 2, 0));
+        pixel[2] = _mm_shuffle_ps(v1, v2, _MM_SHUFFLE(0, 0, 3, 2));
+        pixel[3] = _mm_shuffle_ps(v2, v2, _MM_SHUFFLE(3, 3, 2, 1));
+        __m128i bytes[4];
+        for (int k = 0; k < 4; ++k) {
+            __m128i value = _mm_cvttps_epi32(_mm_mul_ps(toneMap(pixel[k], vscale, curve), v255));
+            bytes[k] = _mm_or_si128(_mm_and_si128(value, rgbMask), alpha);
+        }
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(bytes[0], bytes[1]), _mm_packs_epi32(bytes[2], bytes[3]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4 * i), packed);
+    }
+#endif
+    toRGBA8Portable(in + 3 * i, count - i, scale, curve, out + 4 * i);
+}
+
+// count pixels RGB float para RGB de 16 bits big-endian, o formato do PNG; arredonda
+inline void toRGB16(const float* in, size_t count, float scale, ToneMap curve, unsigned char* out) {
+    size_t i = 0;
+#ifdef HDR_SSE2
+    // 8 pixels (24 valores) por vez; o viés de 32768 deixa o pack com sinal servir para 0..65535
+    const __m128 vscale = _mm_set1_ps(scale), v65535 = _mm_set1_ps(65535.0f), half = _mm_set1_ps(0.5f);
+    const __m128i bias = _mm_set1_epi32(32768), unbias = _mm_set1_epi16(-32768);
+    for (; i + 8 <= count; i += 8) {
+        for (int k = 0; k < 3; ++k) {
+            const float* values = in + 3 * i + 8 * k;
+            __m128i a = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(toneMap(_mm_loadu_ps(values), vscale, curve), v65535), half));
+            __m128i b = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(toneMap(_mm_loadu_ps(values + 4), vscale, curve), v65535), half));
+            __m128i words = _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(a, bias), _mm_sub_epi32(b, bias)), unbias);
+            words = _mm_or_si128(_mm_slli_epi16(words, 8), _mm_srli_epi16(words, 8));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 6 * i + 16 * k), words);
+        }
+    }
+#endif
+    toRGB16Portable(in + 3 * i, count - i, scale, curve, out + 6 * i);
+}
+
+// Aplica convert em faixas de linhas, no pool se houver
+template <typename Convert>
+inline void convertRows(int width, int height, ThreadPool* pool, const Convert& convert) {
+    const int rowsPerBand = 16;
+    int bands = (height + rowsPerBand - 1) / rowsPerBand;
+    auto band = [&](int b) {
+        int y0 = b * rowsPerBand, y1 = std::min(height, y0 + rowsPerBand);
+        convert(size_t(y0) * width, size_t(y1 - y0) * width);
+    };
+    if (pool && bands > 1) pool->parallelFor(bands, band);
+    else for (int b = 0; b < bands; ++b) band(b);
+}
+
+} // namespace hdr
+
+// Framebuffer HDR para o buffer RGBA8 dos encoders, com exposição e curva
+inline void toneMapRGBA8(const std::vector<float>& hdrImage, int width, int height, const ToneMapSettings& toneMap,
+                         std::vector<unsigned char>& image, ThreadPool* pool = nullptr) {
+    image.resize(size_t(width) * height * 4);
+    float scale = float(std::exp2(toneMap.exposure));
+    hdr::convertRows(width, height, pool, [&](size_t first, size_t count) {
+        hdr::toRGBA8(&hdrImage[3 * first], count, scale, toneMap.curve, &image[4 * first]);
+    });
+}
+
+// PNG RGB de 16 bits por canal, gravado em path como o de 8 bits: um bloco de deflate por vez. O buffer
+// já sai no formato do PNG, então o lodepng não converte nada. Devolve o erro do lodepng.
+inline unsigned writePNG16(const std::string& path, const std::vector<float>& hdrImage, int width, int height,
+                           const ToneMapSettings& toneMap, LodePNGCompressionPreset preset = LCP_DEFAULT,
+                           ThreadPool* pool = nullptr) {
+    std::vector<unsigned char> raw(size_t(width) * height * 6);
+    float scale = float(std::exp2(toneMap.exposure));
+    hdr::convertRows(width, height, pool, [&](size_t first, size_t count) {
+        hdr::toRGB16(&hdrImage[3 * first], count, scale, toneMap.curve, &raw[6 * first]);
+    });
+    lodepng::State state;
+    setupPNGState(state, preset, pool);
+    state.info_raw.colortype = LCT_RGB;
+    state.info_raw.bitdepth = 16;
+    state.info_png.color.bitdepth = 16;
+    return lodepng::encode(path, raw.data(), width, height, state);
+}
+
+// PFM (Portable Float Map) colorido com os valores lineares do framebuffer, sem exposição nem curva.
+// Escala -1: floats little-endian; as linhas vão de baixo para cima.
+inline bool writePFM(const std::string& path, const std::vector<float>& hdrImage, int width, int height) {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+    bool ok = std::fprintf(file, "PF\n%d %d\n-1.0\n", width, height) > 0;
+    const uint16_t probe = 1;
+    bool littleEndian = *reinterpret_cast<const unsigned char*>(&probe) == 1;
+    std::vector<unsigned char> row(size_t(width) * 12);
+    for (int y = height - 1; y >= 0 && ok; --y) {
+        std::memcpy(row.data(), &hdrImage[size_t(y) * width * 3], row.size());
+        if (!littleEndian) {
+            for (size_t i = 0; i < row.size(); i += 4) {
+                std::swap(row[i], row[i + 3]);
+                std::swap(row[i + 1], row[i + 2]);
+            }
+        }
+        ok = std::fwrite(row.data(), 1, row.size(), file) == row.size();
+    }
+    return std::fclose(file) == 0 && ok;
+}
+
+#endif // HDR_H
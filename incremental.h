@@ -0,0 +1,257 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+#include "scene.h"
+#include "camera.h"
+#include "tile.h"
+#include "renderer.h"
+#include "thread_pool.h"
+
+// Re-renderização incremental: guarda do quadro anterior a imagem, o ID da primitiva e a
+// profundidade do raio central de cada pixel, e uma cópia da geometria. No quadro seguinte,
+// se só esferas mudaram, re-renderiza apenas os tiles que podem ter mudado:
+//   - pixels que mostravam a esfera (buffer de IDs);
+//   - pixels dentro da projeção na tela da posição antiga ou nova cuja profundidade, no pior
+//     caso da vizinhança 3x3, não está na frente da esfera (buffer de profundidade);
+//   - pixels cujo raio de sombra até alguma luz passa pela posição antiga ou nova.
+// Tudo é dilatado em 1 pixel porque as amostras de anti-aliasing ficam nos cantos do pixel.
+// O renderizador não tem reflexões, então sombras são a única dependência indireta.
+// Mudanças em planos, luzes, câmera ou no número de esferas fazem um quadro completo, assim como
+// câmeras com abertura, em que a projeção pinhole das esferas não limita o desfoque.
+// Esferas em movimento entram pela esfera que envolve todo o trajeto no obturador.
+// Se a cena tem BVH, ela deve ser reconstruída pelo chamador depois da edição.
+class IncrementalRenderer {
+public:
+    int tileSize = 16;
+    int lastTilesRendered = 0;
+    int lastTileCount = 0;
+    bool lastWasFull = false;
+
+    std::vector<unsigned char> image;  // RGBA8 do último quadro
+    std::vector<int> primitiveIds;     // -1 = fundo
+    std::vector<float> depths;         // distância ao longo do raio central; infinito no fundo
+
+    void render(const Scene& scene, const Camera& camera, const RenderSettings& settings, ThreadPool& pool) {
+        int width = camera.hres, height = camera.vres;
+        std::vector<Tile> tiles = makeTiles(width, height, tileSize);
+        std::vector<int> changed;
+        bool incremental = settings.samplingMode != SamplingMode::VarianceAdaptive && !settings.denoise &&
+                           canUpdate(scene, camera, settings, changed);
+
+        std::vector<int> selected;
+        if (incremental) {
+            std::vector<char> affected(size_t(width) * height, 0);
+            for (int id : changed) markAffected(scene, camera, id, affected);
+            int tilesX = (width + tileSize - 1) / tileSize;
+            std::vector<char> tileMask(tiles.size(), 0);
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    if (affected[size_t(y) * width + x]) tileMask[(y / tileSize) * tilesX + x / tileSize] = 1;
+                }
+            }
+            for (size_t i = 0; i < tiles.size(); ++i) {
+                if (tileMask[i]) selected.push_back(int(i));
+            }
+        } else {
+            image.assign(size_t(width) * height * 4, 0);
+            primitiveIds.assign(size_t(width) * height, -1);
+            depths.assign(size_t(width) * height, std::numeric_limits<float>::infinity());
+            for (size_t i = 0; i < tiles.size(); ++i) selected.push_back(int(i));
+        }
+
+        pool.parallelFor(int(selected.size()), [&](int i) { renderTile(scene, camera, settings, tiles[selected[i]]); });
+
+        lastTilesRendered = int(selected.size());
+        lastTileCount = int(tiles.size());
+        lastWasFull = !incremental;
+        snapshot(scene, camera, settings);
+    }
+
+private:
+    std::vector<Sphere> previousSpheres;
+    std::vector<Plane> previousPlanes;
+    std::vector<Light> previousLights;
+    Camera previousCamera = Camera(Point3(0, 0, 0), Point3(0, 0, -1), Vec3(0, 1, 0), 1.0, 0, 0);
+    Vec3 previousBackground, previousAmbient;
+    SamplingMode previousMode = SamplingMode::PixelCenter;
+    bool hasPrevious = false;
+
+    template <typename T>
+    static bool sameArray(ArrayView<T> a, const std::vector<T>& b) {
+        return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+    }
+
+    static bool sameVec(const Vec3& a, const Vec3& b) { return a.x == b.x && a.y == b.y && a.z == b.z; }
+    static bool samePoint(const Point3& a, const Point3& b) { return a.x == b.x && a.y == b.y && a.z == b.z; }
+
+    bool canUpdate(const Scene& scene, const Camera& camera, const RenderSettings& settings, std::vector<int>& changed) const {
+        if (!hasPrevious || settings.samplingMode != previousMode) return false;
+        const Camera& c = previousCamera;
+        if (!samePoint(camera.position, c.position) || !samePoint(camera.lookAt, c.lookAt) || !sameVec(camera.up, c.up) ||
+            camera.distance != c.distance || camera.hres != c.hres || camera.vres != c.vres || camera.aperture > 0 ||
+            c.aperture > 0 || camera.projection != Projection::Perspective || c.projection != Projection::Perspective) {
+            return false;
+        }
+        if (!sameVec(scene.background, previousBackground) || !sameVec(scene.ambient, previousAmbient) ||
+            !sameArray(scene.planeView(), previousPlanes) || !sameArray(scene.lightView(), previousLights)) {
+            return false;
+        }
+        ArrayView<Sphere> spheres = scene.sphereView();
+        if (spheres.size() != previousSpheres.size()) return false;
+        for (size_t i = 0; i < spheres.size(); ++i) {
+            if (std::memcmp(&spheres[i], &previousSpheres[i], sizeof(Sphere)) != 0) changed.push_back(int(i));
+        }
+        return true;
+    }
+
+    void snapshot(const Scene& scene, const Camera& camera, const RenderSettings& settings) {
+        ArrayView<Sphere> spheres = scene.sphereView();
+        ArrayView<Plane> planes = scene.planeView();
+        ArrayView<Light> lights = scene.lightView();
+        previousSpheres.assign(spheres.begin(), spheres.end());
+        previousPlanes.assign(planes.begin(), planes.end());
+        previousLights.assign(lights.begin(), lights.end());
+        previousCamera = camera;
+        previousBackground = scene.background;
+        previousAmbient = scene.ambient;
+        previousMode = settings.samplingMode;
+        hasPrevious = true;
+    }
+
+    void renderTile(const Scene& scene, const Camera& camera, const RenderSettings& settings, const Tile& tile) {
+        std::vector<unsigned char> pixels(size_t(tile.x1 - tile.x0) * (tile.y1 - tile.y0) * 4);
+        renderTileRGBA(scene, camera, settings, tile, pixels);
+        size_t rowBytes = size_t(tile.x1 - tile.x0) * 4;
+        for (int y = tile.y0; y < tile.y1; ++y) {
+            std::memcpy(&image[(size_t(y) * camera.hres + tile.x0) * 4], &pixels[(y - tile.y0) * rowBytes], rowBytes);
+            for (int x = tile.x0; x < tile.x1; ++x) {
+                size_t index = size_t(y) * camera.hres + x;
+                Intersection hit(0, Vec3());
+                if (intersectScene(scene, primaryRay(camera, x + 0.5, y + 0.5), hit)) {
+                    primitiveIds[index] = hit.id;
+                    depths[index] = float(hit.distance);
+                } else {
+                    primitiveIds[index] = -1;
+                    depths[index] = std::numeric_limits<float>::infinity();
+                }
+            }
+        }
+    }
+
+    // Retângulo de pixels que contém a projeção da caixa da esfera; false se a caixa cruza o
+    // plano da câmera, caso em que a tela inteira pode ser afetada
+    static bool projectSphere(const Camera& camera, const Sphere& sphere, int& x0, int& y0, int& x1, int& y1) {
+        Vec3 u, v, w;
+        camera.getCameraBasis(u, v, w);
+        double aspect = double(camera.hres) / double(camera.vres);
+        double minX = std::numeric_limits<double>::max(), minY = minX, maxX = -minX, maxY = -minX;
+        Point3 center = sphere.sweptCenter();
+        double radius = sphere.sweptRadius();
+        for (int corner = 0; corner < 8; ++corner) {
+            Vec3 rel(center.x + (corner & 1 ? radius : -radius) - camera.position.x,
+                     center.y + (corner & 2 ? radius : -radius) - camera.position.y,
+                     center.z + (corner & 4 ? radius : -radius) - camera.position.z);
+            double forward = -rel.dot(w);
+            if (forward <= 1e-9) return false;
+            double uc = rel.dot(u) * camera.distance / forward;
+            double vc = rel.dot(v) * camera.distance / forward;
+            double px = (uc / aspect + 1) * 0.5 * camera.hres;
+            double py = (1 - vc) * 0.5 * camera.vres;
+            minX = std::min(minX, px);
+            maxX = std::max(maxX, px);
+            minY = std::min(minY, py);
+            maxY = std::max(maxY, py);
+        }
+        x0 = int(std::max(-1.0, std::floor(minX)));
+        y0 = int(std::max(-1.0, std::floor(minY)));
+        x1 = int(std::min(double(camera.hres), std::ceil(maxX)));
+        y1 = int(std::min(double(camera.vres), std::ceil(maxY)));
+        return true;
+    }
+
+    // Maior profundidade na vizinhança 3x3: as amostras de canto do pixel podem ver além do centro
+    float neighbourhoodDepth(int x, int y, int width, int height) const {
+        float depth = 0;
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                int nx = std::min(std::max(x + dx, 0), width - 1), ny = std::min(std::max(y + dy, 0), height - 1);
+                depth = std::max(depth, depths[size_t(ny) * width + nx]);
+            }
+        }
+        return depth;
+    }
+
+    static bool segmentHitsSphere(const Point3& origin, const Vec3& direction, double length, const Point3& center, double radius) {
+        Vec3 oc(center.x - origin.x, center.y - origin.y, center.z - origin.z);
+        double t = std::min(std::max(oc.dot(direction), 0.0), length);
+        Vec3 closest(oc.x - direction.x * t, oc.y - direction.y * t, oc.z - direction.z * t);
+        return closest.dot(closest) <= radius * radius;
+    }
+
+    void markAffected(const Scene& scene, const Camera& camera, int id, std::vector<char>& affected) const {
+        int width = camera.hres, height = camera.vres;
+        const Sphere& before = previousSpheres[id];
+        const Sphere& after = scene.sphereView()[id];
+        bool moved = !samePoint(before.center, after.center) || before.radius != after.radius || !sameVec(before.motion, after.motion);
+        std::vector<char> hits(affected.size(), 0);
+
+        for (size_t i = 0; i < hits.size(); ++i) hits[i] = primitiveIds[i] == id;
+
+        if (moved) {
+            const Sphere* positions[2] = { &before, &after };
+            for (const Sphere* sphere : positions) {
+                int x0 = 0, y0 = 0, x1 = width, y1 = height;
+                if (!projectSphere(camera, *sphere, x0, y0, x1, y1)) {
+                    x0 = y0 = 0;
+                    x1 = width;
+                    y1 = height;
+                }
+                Point3 swept = sphere->sweptCenter();
+                Vec3 toCenter(swept.x - camera.position.x, swept.y - camera.position.y, swept.z - camera.position.z);
+                double nearest = toCenter.length() - sphere->sweptRadius();
+                for (int y = std::max(y0, 0); y < std::min(y1 + 1, height); ++y) {
+                    for (int x = std::max(x0, 0); x < std::min(x1 + 1, width); ++x) {
+                        if (neighbourhoodDepth(x, y, width, height) >= nearest) hits[size_t(y) * width + x] = 1;
+                    }
+                }
+            }
+
+            ArrayView<Light> lights = scene.lightView();
+            for (int y = 0; y < height && !lights.empty(); ++y) {
+                for (int x = 0; x < width; ++x) {
+                    size_t index = size_t(y) * width + x;
+                    if (hits[index] || primitiveIds[index] < 0) continue;
+                    Ray ray = primaryRay(camera, x + 0.5, y + 0.5);
+                    Point3 p(ray.origin.x + depths[index] * ray.direction.x, ray.origin.y + depths[index] * ray.direction.y,
+                             ray.origin.z + depths[index] * ray.direction.z);
+                    for (const auto& light : lights) {
+                        Vec3 toLight(light.position.x - p.x, light.position.y - p.y, light.position.z - p.z);
+                        double length = toLight.length();
+                        Vec3 l = toLight / length;
+                        if (segmentHitsSphere(p, l, length, before.sweptCenter(), before.sweptRadius() * 1.01) ||
+                            segmentHitsSphere(p, l, length, after.sweptCenter(), after.sweptRadius() * 1.01)) {
+                            hits[index] = 1;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                if (!hits[size_t(y) * width + x]) continue;
+                for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, height - 1); ++ny) {
+                    for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, width - 1); ++nx) affected[size_t(ny) * width + nx] = 1;
+                }
+            }
+        }
+    }
+};
+
+#endif // INCREMENTAL_H
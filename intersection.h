@@ -7,8 +7,11 @@ class Intersection {
 public:
     double distance;
     Vec3 color;
+    Vec3 normal;
+    int id; // índice da primitiva atingida na cena, -1 se ainda não atribuído
 
-    Intersection(double d, Vec3 c) : distance(d), color(c) {}
+    Intersection(double d, Vec3 c) : distance(d), color(c), normal(), id(-1) {}
+    Intersection(double d, Vec3 c, Vec3 n) : distance(d), color(c), normal(n), id(-1) {}
 };
 
 #endif // INTERSECTION_H
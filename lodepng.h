@@ -93,7 +93,7 @@ or comment out LODEPNG_COMPILE_ALLOCATORS below*/
 
 /*Disable built-in CRC function, in that case a custom implementation of
 lodepng_crc32 must be defined externally so that it can be linked in.
-The default built-in CRC code comes with 8KB of lookup tables, so for memory constrained environment you may want it
+The default built-in CRC code comes with 16KB of lookup tables (slicing-by-16), so for memory constrained environment you may want it
 disabled and provide a much smaller implementation externally as said above. You can find such an example implementation
 in a comment in the lodepng.c(pp) file in the 'else' case of the searchable LODEPNG_COMPILE_CRC section.*/
 #ifndef LODEPNG_NO_COMPILE_CRC
@@ -102,6 +102,14 @@ or comment out LODEPNG_COMPILE_CRC below*/
 #define LODEPNG_COMPILE_CRC
 #endif
 
+/*Runtime selection of the x86-64 checksum kernels (PCLMULQDQ for CRC32, SSSE3 and AVX2 for Adler-32). They are compiled with
+per-function target attributes on GCC and Clang, so the rest of the code keeps the baseline instruction set.*/
+#ifndef LODEPNG_NO_COMPILE_CPU_DISPATCH
+/*pass -DLODEPNG_NO_COMPILE_CPU_DISPATCH to the compiler to use only the portable code,
+or comment out LODEPNG_COMPILE_CPU_DISPATCH below*/
+#define LODEPNG_COMPILE_CPU_DISPATCH
+#endif
+
 /*compile the C++ version (you can disable the C++ wrapper here even when compiling for C++)*/
 #ifdef __cplusplus
 #ifndef LODEPNG_NO_COMPILE_CPP
@@ -116,6 +124,38 @@ or comment out LODEPNG_COMPILE_CPP below*/
 #include <string>
 #endif /*LODEPNG_COMPILE_CPP*/
 
+/*CPU features the checksum and filter kernels can use, as bits*/
+typedef enum LodePNGCPUFeature {
+  LCPU_PCLMUL = 1, /*carry-less multiplication, for CRC32*/
+  LCPU_SSSE3 = 2, /*byte multiply-add, for Adler-32*/
+  LCPU_AVX2 = 4, /*the same in 256-bit registers*/
+  LCPU_SSE2 = 8 /*16-byte scanline filters, part of every x86-64 CPU*/
+} LodePNGCPUFeature;
+
+#ifdef LODEPNG_COMPILE_ALLOCATORS
+/*Functions that the built-in allocators call instead of malloc, realloc and free, e.g. a pool of
+blocks reused from one image to the next. Each one gets context as its last argument.*/
+typedef struct LodePNGAllocator {
+  void* (*allocate)(size_t size, void* context);
+  void* (*reallocate)(void* ptr, size_t new_size, void* context);
+  void (*release)(void* ptr, void* context);
+  void* context;
+} LodePNGAllocator;
+
+/*Makes every following allocation of lodepng on the calling thread use allocator, or malloc again
+if NULL, and returns the previous one. Other threads are not affected. Memory must be freed while
+the allocator that allocated it is active, this includes the buffers that encode and decode return.
+The parallel_for tasks of the encoder do not allocate, so the calling thread's allocator covers them.*/
+const LodePNGAllocator* lodepng_set_thread_allocator(const LodePNGAllocator* allocator);
+#endif /*LODEPNG_COMPILE_ALLOCATORS*/
+
+/*The LodePNGCPUFeature bits that this CPU supports and that are enabled*/
+unsigned lodepng_cpu_features(void);
+/*Enables only the given LodePNGCPUFeature bits, e.g. 0 to run the portable code for validation
+or benchmarks. Returns the previous mask. The mask is a plain global: only call this while no thread
+is encoding or decoding, e.g. between runs of a benchmark.*/
+unsigned lodepng_set_cpu_features(unsigned mask);
+
 #ifdef LODEPNG_COMPILE_PNG
 /*The PNG color types (also used for raw image).*/
 typedef enum LodePNGColorType {
@@ -224,6 +264,10 @@ Same as the other encode functions, but instead takes a filename as output.
 
 NOTE: This overwrites existing files without warning!
 
+The PNG is streamed into filename + ".part" in the same directory, which is renamed over
+filename only on success: on error an existing file is left untouched and no partial file
+remains.
+
 NOTE: Wide-character filenames are not supported, you can use an external method
 to handle such files and encode in-memory.*/
 unsigned lodepng_encode_file(const char* filename,
@@ -347,6 +391,21 @@ void lodepng_decompress_settings_init(LodePNGDecompressSettings* settings);
 Settings for zlib compression. Tweaking these settings tweaks the balance
 between speed and compression ratio.
 */
+/*LZ77 match finders, see matchfinder in LodePNGCompressSettings*/
+typedef enum LodePNGMatchFinder {
+  /*hash chains, with a second chain for runs of zeros. The default*/
+  LMF_CHAIN = 0,
+  /*only matches at distance 1, runs of the previous byte like zlib's Z_RLE. Filtered flat
+  image regions are long runs of zeros, so this keeps much of the gain at a fraction of the time*/
+  LMF_RLE = 1,
+  /*a single probe of a 4-byte hash per position, without chains or lazy matching*/
+  LMF_FAST = 2,
+  /*hash chains of 4-byte hashes searched at most maxchain deep. Runs of the previous byte are matched
+  without a search, and long matches only insert their first and last positions, so flat image regions
+  don't flood the chains. Honors lazymatching; matches are at least 4 long*/
+  LMF_HASH4 = 3
+} LodePNGMatchFinder;
+
 typedef struct LodePNGCompressSettings LodePNGCompressSettings;
 struct LodePNGCompressSettings /*deflate = compress*/ {
   /*LZ77 related settings*/
@@ -356,6 +415,8 @@ struct LodePNGCompressSettings /*deflate = compress*/ {
   unsigned minmatch; /*minimum lz77 length. 3 is normally best, 6 can be better for some PNGs. Default: 0*/
   unsigned nicematch; /*stop searching if >= this length found. Set to 258 for best compression. Default: 128*/
   unsigned lazymatching; /*use lazy matching: better compression but a bit slower. Default: true*/
+  LodePNGMatchFinder matchfinder; /*how LZ77 matches are searched. Default: LMF_CHAIN*/
+  unsigned maxchain; /*LMF_HASH4 only: most candidates compared per position. Default: 32*/
 
   /*use custom zlib encoder instead of built in one (default: null)*/
   unsigned (*custom_zlib)(unsigned char**, size_t*,
@@ -841,6 +902,14 @@ typedef struct LodePNGEncoderSettings {
   NOTE: enabling this may worsen compression if auto_convert is used to choose
   optimal color mode, because it cannot use grayscale color modes in this case*/
   unsigned force_palette;
+
+  /*optional: lets the scanline filtering run on multiple threads. The rows are filtered in bands that
+  only read the unfiltered image, so they are independent. If set, this must call task(task_context, i)
+  once for every i in [0, count), in any order and possibly in parallel, and return when all are done.
+  parallel_context is passed back as-is. Not used by LFS_BRUTE_FORCE. Default: NULL (serial)*/
+  void (*parallel_for)(void (*task)(void* task_context, unsigned i), void* task_context, unsigned count,
+                       const void* parallel_context);
+  const void* parallel_context;
 #ifdef LODEPNG_COMPILE_ANCILLARY_CHUNKS
   /*add LodePNG identifier and version as a text chunk, for debugging*/
   unsigned add_id;
@@ -850,6 +919,19 @@ typedef struct LodePNGEncoderSettings {
 } LodePNGEncoderSettings;
 
 void lodepng_encoder_settings_init(LodePNGEncoderSettings* settings);
+
+/*Named tradeoffs between encoding speed and file size, from fastest to smallest*/
+typedef enum LodePNGCompressionPreset {
+  LCP_STORE, /*stored deflate blocks and no filtering: only the PNG and zlib framing*/
+  LCP_HUFFMAN, /*dynamic Huffman codes of Sub-filtered bytes, without LZ77*/
+  LCP_RLE, /*Sub filter, Huffman and runs at distance 1 (LMF_RLE)*/
+  LCP_FAST, /*Sub filter, Huffman and LZ77 with 4-deep 4-byte hash chains (LMF_HASH4)*/
+  LCP_DEFAULT, /*the settings of lodepng_encoder_settings_init*/
+  LCP_MAX /*32K window with full hash chains and 258-byte matches*/
+} LodePNGCompressionPreset;
+
+/*Sets the compression and filter settings of a preset, leaving the other settings alone*/
+void lodepng_encoder_settings_preset(LodePNGEncoderSettings* settings, LodePNGCompressionPreset preset);
 #endif /*LODEPNG_COMPILE_ENCODER*/
 
 
@@ -912,6 +994,22 @@ unsigned lodepng_inspect_chunk(LodePNGState* state, size_t pos,
 unsigned lodepng_encode(unsigned char** out, size_t* outsize,
                         const unsigned char* image, unsigned w, unsigned h,
                         LodePNGState* state);
+
+/*Receives the PNG file of lodepng_encode_stream in order, piece by piece. Returns 0, or an error code that
+stops the encoding and is returned by lodepng_encode_stream.*/
+typedef unsigned (*LodePNGWriteCallback)(const unsigned char* data, size_t size, void* context);
+
+/*
+Same as lodepng_encode, but the file goes to write as it is produced instead of into one buffer: first
+the signature and the chunks before IDAT, then an IDAT chunk after each deflate block, then the rest.
+Besides the filtered scanlines, only the compressed data of one deflate block is kept in memory, so
+large images need about half the memory. The file differs from lodepng_encode's only in how the zlib
+data is split over IDAT chunks (and in block boundaries for btype 0 and 1). With custom_zlib or
+custom_deflate the data is compressed at once and written as a single IDAT chunk.
+*/
+unsigned lodepng_encode_stream(LodePNGWriteCallback write, void* context,
+                               const unsigned char* image, unsigned w, unsigned h,
+                               LodePNGState* state);
 #endif /*LODEPNG_COMPILE_ENCODER*/
 
 /*
@@ -1007,6 +1105,13 @@ unsigned lodepng_chunk_create(unsigned char** out, size_t* outsize, size_t lengt
 
 /*Calculate CRC32 of buffer*/
 unsigned lodepng_crc32(const unsigned char* buf, size_t len);
+#ifdef LODEPNG_COMPILE_CRC
+/*Continue a CRC32: crc is the result for the data before buf (0 to start)*/
+unsigned lodepng_crc32_update(unsigned crc, const unsigned char* buf, size_t len);
+#endif /*LODEPNG_COMPILE_CRC*/
+/*CRC32 of the concatenation A+B given crc1 of A, crc2 of B and len2 the length of B,
+so that pieces of one buffer can be checksummed in parallel*/
+unsigned lodepng_crc32_combine(unsigned crc1, unsigned crc2, size_t len2);
 #endif /*LODEPNG_COMPILE_PNG*/
 
 
@@ -1017,6 +1122,12 @@ buffer. It cannot be used to create gzip files however, and it only supports the
 part of zlib that is required for PNG, it does not support dictionaries.
 */
 
+/*Adler-32 checksum of the zlib format, continuing from adler (1 to start)*/
+unsigned lodepng_adler32_update(unsigned adler, const unsigned char* data, size_t len);
+/*Adler-32 of the concatenation A+B given adler1 of A, adler2 of B and len2 the length of B,
+so that pieces of one buffer can be checksummed in parallel*/
+unsigned lodepng_adler32_combine(unsigned adler1, unsigned adler2, size_t len2);
+
 #ifdef LODEPNG_COMPILE_DECODER
 /*Inflate a buffer. Inflate is the decompression step of deflate. Out buffer must be freed after use.*/
 unsigned lodepng_inflate(unsigned char** out, size_t* outsize,
@@ -1119,6 +1230,16 @@ unsigned encode(std::vector<unsigned char>& out,
 unsigned encode(std::vector<unsigned char>& out,
                 const std::vector<unsigned char>& in, unsigned w, unsigned h,
                 State& state);
+#ifdef LODEPNG_COMPILE_DISK
+/* Same as other lodepng::encode to a file, using a State. The file is written with lodepng_encode_stream,
+through a temporary file like lodepng_encode_file. */
+unsigned encode(const std::string& filename,
+                const unsigned char* in, unsigned w, unsigned h,
+                State& state);
+unsigned encode(const std::string& filename,
+                const std::vector<unsigned char>& in, unsigned w, unsigned h,
+                State& state);
+#endif /* LODEPNG_COMPILE_DISK */
 #endif /*LODEPNG_COMPILE_ENCODER*/
 
 #ifdef LODEPNG_COMPILE_DISK
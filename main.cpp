@@ -1,118 +1,523 @@
 #include <iostream>
 #include <vector>
-#include <limits>
-#include "ray.h"
-#include "sphere.h"
-#include "plane.h"
-#include "intersection.h"
-#include "camera.h"
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include "scene.h"
+#include "scene_cache.h"
+#include "renderer.h"
+#include "render_server.h"
+#include "incremental.h"
+#include "animation.h"
+#include "batch.h"
+#include "benchmark.h"
+#include "hdr.h"
 #include "lodepng.h"
 #include <fstream>
 
-bool findClosestIntersection(const Ray& ray, const std::vector<Sphere>& spheres, const std::vector<Plane>& planes, Intersection& closestIntersection) {
-    bool hasIntersection = false;
-    double closestDistance = std::numeric_limits<double>::max();
+static void printUsage(const char* program) {
+    std::cout << "Uso: " << program << " [opções]\n"
+              << "  -i, --scene <arquivo>       cena em texto ou cache binário (padrão: cena embutida)\n"
+              << "      --convert-scene <arq>   grava a cena carregada como cache binário e sai\n"
+              << "      --skip-checksums        não confere o CRC das seções ao mapear um cache binário\n"
+              << "      --bvh-cache <dir>       guarda e reutiliza a BVH da cena em <dir>, pelo hash da geometria\n"
+              << "  -o, --output <arquivo>      imagem de saída .png, .ppm, .qoi ou .pfm (float linear)\n"
+              << "                              (padrão: output.png e output.ppm)\n"
+              << "      --width <n>             largura em pixels\n"
+              << "      --height <n>            altura em pixels\n"
+              << "  -r, --resolution <LxA>      largura e altura, ex. 1920x1080\n"
+              << "      --aperture <r>          raio da lente para profundidade de campo (0 = pinhole)\n"
+              << "      --focus <d>             distância do plano em foco\n"
+              << "      --projection <p>        perspective, equirect (360°) ou cubemap (6 faces de altura x altura;\n"
+              << "                              com %d em -o grava uma imagem por face)\n"
+              << "      --compression <p>       preset do PNG: store, huffman, rle, fast, default ou max\n"
+              << "      --bit-depth <n>         bits por canal do PNG: 8 ou 16 (padrão: 8)\n"
+              << "      --tonemap <curva>       clamp, reinhard ou aces, aplicada ao framebuffer float (padrão: clamp)\n"
+              << "      --exposure <ev>         exposição em stops antes da curva (padrão: 0)\n"
+              << "      --sampling <modo>       center, variance ou edge (padrão: center)\n"
+              << "      --spp <n>               máximo de amostras por pixel no modo variance\n"
+              << "      --heatmap <arquivo>     mapa de amostras do modo variance (padrão: heatmap.png, \"\" desativa)\n"
+              << "      --denoise               aplica o denoiser à-trous\n"
+              << "      --workers <n>           renderiza tiles em n processos locais\n"
+              << "      --remote <host:porta>   adiciona um worker TCP (pode repetir)\n"
+              << "      --worker-port <porta>   roda como worker TCP de tiles\n"
+              << "      --server <socket>       roda como servidor de renderização no socket Unix dado\n"
+              << "      --threads <n>           threads do servidor (padrão: uma por núcleo)\n"
+              << "      --nudge <i:dx,dy,dz>    renderiza, move a esfera i e re-renderiza só os tiles afetados\n"
+              << "      --animation <arq>       renderiza a animação descrita no arquivo; -o com %d no nome (padrão: frame_%04d.png)\n"
+              << "      --in-flight <n>         quadros da animação renderizados ao mesmo tempo (padrão: --threads)\n"
+              << "      --views <arq>           renderiza uma imagem por câmera do arquivo; -o com %d (padrão: view_%03d.png)\n"
+              << "      --turntable <n>         renderiza n vistas girando a câmera em volta do alvo\n"
+              << "      --benchmark <nome>      mede as rotinas de saída de imagem: crc32, adler32, compression, filters, lz77,\n"
+              << "                              memory, stream, qoi, hdr\n"
+              << "      --help                  mostra esta ajuda\n";
+}
 
-    for (const auto& sphere : spheres) {
-        Intersection intersection(0, Vec3());
-        if (sphere.intersect(ray, intersection) && intersection.distance < closestDistance) {
-            closestDistance = intersection.distance;
-            closestIntersection = intersection;
-            hasIntersection = true;
-        }
+static bool endsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static bool savePNG(const std::string& path, const std::vector<unsigned char>& image, int width, int height,
+                    LodePNGCompressionPreset preset, ThreadPool& pool) {
+    std::cout << "Salvando a imagem em formato PNG..." << std::endl;
+    // Salva a imagem usando lodepng, gravando cada bloco comprimido no arquivo assim que fica pronto
+    lodepng::State state;
+    setupPNGState(state, preset, &pool);
+    unsigned error = lodepng::encode(path, image.data(), width, height, state);
+    if (error) {
+        std::cout << "Encoder error " << error << ": " << lodepng_error_text(error) << std::endl;
+        return false;
     }
+    std::cout << "Imagem PNG salva com sucesso." << std::endl;
+    return true;
+}
 
-    for (const auto& plane : planes) {
-        Intersection intersection(0, Vec3());
-        if (plane.intersect(ray, intersection) && intersection.distance < closestDistance) {
-            closestDistance = intersection.distance;
-            closestIntersection = intersection;
-            hasIntersection = true;
-        }
+static bool saveQOI(const std::string& path, const std::vector<unsigned char>& image, int width, int height,
+                    ThreadPool& pool) {
+    std::cout << "Salvando a imagem em formato QOI..." << std::endl;
+    std::vector<unsigned char> qoi;
+    encodeQOI(image, width, height, qoi, &pool);
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(qoi.data()), std::streamsize(qoi.size()));
+    if (!file) {
+        std::cout << "Erro ao gravar " << path << std::endl;
+        return false;
     }
+    std::cout << "Imagem QOI salva com sucesso." << std::endl;
+    return true;
+}
 
-    return hasIntersection;
+static bool savePNG16(const std::string& path, const std::vector<float>& hdrImage, int width, int height,
+                      const ToneMapSettings& toneMap, LodePNGCompressionPreset preset, ThreadPool& pool) {
+    std::cout << "Salvando a imagem em formato PNG de 16 bits..." << std::endl;
+    unsigned error = writePNG16(path, hdrImage, width, height, toneMap, preset, &pool);
+    if (error) {
+        std::cout << "Encoder error " << error << ": " << lodepng_error_text(error) << std::endl;
+        return false;
+    }
+    std::cout << "Imagem PNG salva com sucesso." << std::endl;
+    return true;
 }
 
-void render(const Camera& camera, const std::vector<Sphere>& spheres, const std::vector<Plane>& planes, std::vector<unsigned char>& image) {
-    std::cout << "Iniciando renderização..." << std::endl;
-
-    for (int y = 0; y < camera.vres; ++y) {
-        for (int x = 0; x < camera.hres; ++x) {
-            Ray ray = camera.getRay(x, y);
-
-            Intersection closestIntersection(0, Vec3());
-            if (findClosestIntersection(ray, spheres, planes, closestIntersection)) {
-                int index = 4 * (y * camera.hres + x);
-                image[index + 0] = static_cast<unsigned char>(closestIntersection.color.x * 255);
-                image[index + 1] = static_cast<unsigned char>(closestIntersection.color.y * 255);
-                image[index + 2] = static_cast<unsigned char>(closestIntersection.color.z * 255);
-                image[index + 3] = 255;
-            } else {
-                int index = 4 * (y * camera.hres + x);
-                image[index + 0] = 0;
-                image[index + 1] = 0;
-                image[index + 2] = 0;
-                image[index + 3] = 255;
+static bool savePFM(const std::string& path, const std::vector<float>& hdrImage, int width, int height) {
+    std::cout << "Salvando a imagem em formato PFM..." << std::endl;
+    if (!writePFM(path, hdrImage, width, height)) {
+        std::cout << "Erro ao gravar " << path << std::endl;
+        return false;
+    }
+    std::cout << "Imagem PFM salva com sucesso." << std::endl;
+    return true;
+}
+
+static bool savePPM(const std::string& path, const std::vector<unsigned char>& image, int width, int height) {
+    std::cout << "Salvando a imagem em formato PPM..." << std::endl;
+    // Salva a imagem em formato PPM
+    std::ofstream ppm(path);
+    if (!ppm.is_open()) {
+        std::cout << "Erro ao abrir o arquivo PPM para escrita." << std::endl;
+        return false;
+    }
+    std::string text;
+    encodePPM(image, width, height, text);
+    ppm << text;
+    ppm.close();
+    std::cout << "Imagem PPM salva com sucesso." << std::endl;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::string scenePath;
+    std::string outputPath;
+    std::string convertPath;
+    std::string bvhCacheDir;
+    bool verifyChecksums = true;
+    int width = 0, height = 0;
+    double aperture = -1, focusDistance = -1;
+    Projection projection = Projection::Perspective;
+    LodePNGCompressionPreset compression = LCP_DEFAULT;
+    int bitDepth = 8;
+    ToneMapSettings toneMap;
+    bool toneMapGiven = false;
+    int workerPort = 0;
+    std::string serverSocket;
+    int threads = 0;
+    std::string animationPath;
+    std::string viewsPath;
+    int turntableViews = 0;
+    std::string benchmarkName;
+    int inFlightFrames = 0;
+    int nudgeSphere = -1;
+    double nudge[3] = { 0, 0, 0 };
+    RenderSettings settings;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg == "--denoise") {
+            settings.denoise = true;
+            continue;
+        } else if (arg == "--skip-checksums") {
+            verifyChecksums = false;
+            continue;
+        }
+        if (!hasValue) {
+            std::cout << "Opção desconhecida ou sem valor: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "-i" || arg == "--scene") {
+            scenePath = value;
+        } else if (arg == "--convert-scene") {
+            convertPath = value;
+        } else if (arg == "--bvh-cache") {
+            bvhCacheDir = value;
+        } else if (arg == "-o" || arg == "--output") {
+            outputPath = value;
+        } else if (arg == "--width") {
+            width = std::atoi(value.c_str());
+        } else if (arg == "--height") {
+            height = std::atoi(value.c_str());
+        } else if (arg == "-r" || arg == "--resolution") {
+            if (std::sscanf(value.c_str(), "%dx%d", &width, &height) != 2) {
+                std::cout << "Resolução inválida: " << value << std::endl;
+                return 1;
+            }
+        } else if (arg == "--aperture") {
+            aperture = std::max(0.0, std::atof(value.c_str()));
+        } else if (arg == "--focus") {
+            focusDistance = std::atof(value.c_str());
+        } else if (arg == "--projection") {
+            if (!parseProjection(value, projection)) {
+                std::cout << "Projeção desconhecida: " << value << std::endl;
+                return 1;
+            }
+        } else if (arg == "--compression") {
+            if (!parseCompressionPreset(value, compression)) {
+                std::cout << "Preset de compressão desconhecido: " << value << std::endl;
+                return 1;
+            }
+        } else if (arg == "--bit-depth") {
+            bitDepth = std::atoi(value.c_str());
+            if (bitDepth != 8 && bitDepth != 16) {
+                std::cout << "Profundidade de bits inválida: " << value << std::endl;
+                return 1;
             }
+        } else if (arg == "--tonemap") {
+            if (!parseToneMap(value, toneMap.curve)) {
+                std::cout << "Curva de tone mapping desconhecida: " << value << std::endl;
+                return 1;
+            }
+            toneMapGiven = true;
+        } else if (arg == "--exposure") {
+            toneMap.exposure = std::atof(value.c_str());
+            toneMapGiven = true;
+        } else if (arg == "--sampling") {
+            if (value == "center") settings.samplingMode = SamplingMode::PixelCenter;
+            else if (value == "variance") settings.samplingMode = SamplingMode::VarianceAdaptive;
+            else if (value == "edge") settings.samplingMode = SamplingMode::EdgeAdaptive;
+            else {
+                std::cout << "Modo de amostragem desconhecido: " << value << std::endl;
+                return 1;
+            }
+        } else if (arg == "--spp") {
+            settings.adaptiveSettings.maxSamples = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--heatmap") {
+            settings.heatmapPath = value;
+        } else if (arg == "--workers") {
+            settings.workerProcesses = std::max(0, std::atoi(value.c_str()));
+        } else if (arg == "--remote") {
+            settings.remoteWorkers.push_back(value);
+        } else if (arg == "--worker-port") {
+            workerPort = std::atoi(value.c_str());
+        } else if (arg == "--server") {
+            serverSocket = value;
+        } else if (arg == "--nudge") {
+            if (std::sscanf(value.c_str(), "%d:%lf,%lf,%lf", &nudgeSphere, &nudge[0], &nudge[1], &nudge[2]) != 4) {
+                std::cout << "Deslocamento inválido: " << value << std::endl;
+                return 1;
+            }
+        } else if (arg == "--views") {
+            viewsPath = value;
+        } else if (arg == "--turntable") {
+            turntableViews = std::max(0, std::atoi(value.c_str()));
+        } else if (arg == "--animation") {
+            animationPath = value;
+        } else if (arg == "--in-flight") {
+            inFlightFrames = std::max(0, std::atoi(value.c_str()));
+        } else if (arg == "--benchmark") {
+            benchmarkName = value;
+        } else if (arg == "--threads") {
+            threads = std::max(0, std::atoi(value.c_str()));
+        } else {
+            std::cout << "Opção desconhecida: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
         }
     }
 
-    std::cout << "Renderização concluída." << std::endl;
-}
+    // Com vistas, animação ou faces do cube map, um '%' em -o faz dele o padrão dos nomes
+    bool sequenceOutput = !viewsPath.empty() || turntableViews > 0 || !animationPath.empty() ||
+                          projection == Projection::CubeMap;
+    if (sequenceOutput && outputPath.find('%') != std::string::npos && !isNumberedPattern(outputPath)) {
+        std::cout << "Padrão de saída inválido: " << outputPath << " (use um único %d, ex. frame_%04d.png, e %% para '%')"
+                  << std::endl;
+        return 1;
+    }
 
-int main() {
-    Point3 cameraPosition(0, 0, 0);
-    Point3 lookAt(0, 0, -1);
-    Vec3 up(0, 1, 0);
-    double distance = 1.0;
-    int vres = 500;
-    int hres = 500;
-
-    Camera camera(cameraPosition, lookAt, up, distance, vres, hres);
-
-    std::vector<Sphere> spheres = {
-        Sphere(Point3(-1.5, -0.5, -2.5), 0.6, Vec3(0, 0, 0)),
-        Sphere(Point3(0.8, -0.9, -3), 0.8, Vec3(0, 1, 0)),
-        Sphere(Point3(0.5, -0.5, -1.5), 0.28, Vec3(1, 1, 0)),
-        Sphere(Point3(1.5, 2, -3), 0.58, Vec3(0, 1, 1)),
-        Sphere(Point3(2.5, 1, -5), 0.48, Vec3(1, 0, 0))
-    };
-    std::vector<Plane> planes = {
-        Plane(Point3(0, -1, 0), Vec3(0, 1, 0), Vec3(1, 0, 1))
-    };
-
-    std::vector<unsigned char> image(camera.hres * camera.vres * 4);
-    render(camera, spheres, planes, image);
+    // Framebuffer float quando a saída precisa de mais que 8 bits ou de exposição e tone mapping. Só a
+    // imagem única passa por ele: vistas, animação e --nudge gravam RGBA8.
+    bool hdrOutput = endsWith(outputPath, ".pfm") || bitDepth == 16 || toneMapGiven;
+    if (bitDepth == 16 && (endsWith(outputPath, ".ppm") || endsWith(outputPath, ".qoi"))) {
+        std::cout << "16 bits por canal só em PNG." << std::endl;
+        return 1;
+    }
+    if ((endsWith(outputPath, ".pfm") || bitDepth == 16) && outputPath.find('%') != std::string::npos) {
+        std::cout << "PFM e PNG de 16 bits gravam a imagem inteira, sem %d no nome." << std::endl;
+        return 1;
+    }
+    if (hdrOutput && (!viewsPath.empty() || turntableViews > 0 || !animationPath.empty())) {
+        std::cout << ".pfm, --bit-depth 16, --tonemap e --exposure valem só para a imagem única, não para "
+                  << "--views, --turntable ou --animation." << std::endl;
+        return 1;
+    }
+    if (hdrOutput && nudgeSphere >= 0) {
+        std::cout << "--nudge grava só imagens de 8 bits, sem tone mapping." << std::endl;
+        return 1;
+    }
+    // Os workers só renderizam tiles com amostragem center ou edge
+    bool distributed = settings.workerProcesses > 0 || !settings.remoteWorkers.empty();
+    if (distributed && (settings.samplingMode == SamplingMode::VarianceAdaptive || settings.denoise)) {
+        std::cout << "--workers e --remote não suportam --sampling variance nem --denoise." << std::endl;
+        return 1;
+    }
+    if (distributed && (!viewsPath.empty() || turntableViews > 0 || !animationPath.empty())) {
+        std::cout << "--workers e --remote valem só para a imagem única, não para --views, --turntable ou --animation."
+                  << std::endl;
+        return 1;
+    }
 
-    std::cout << "Salvando a imagem em formato PNG..." << std::endl;
-    // Salva a imagem usando lodepng
-    unsigned error = lodepng::encode("output.png", image, camera.hres, camera.vres);
-    if (error) {
-        std::cout << "Encoder error " << error << ": " << lodepng_error_text(error) << std::endl;
+    if (!serverSocket.empty()) {
+#ifndef _WIN32
+        RenderServerSettings serverSettings;
+        serverSettings.socketPath = serverSocket;
+        serverSettings.threads = threads;
+        serverSettings.bvhCacheDir = bvhCacheDir;
+        RenderServer server(serverSettings);
+        if (server.run() != 0) {
+            std::cout << "Não foi possível escutar em " << serverSocket << std::endl;
+            return 1;
+        }
+        return 0;
+#else
+        std::cout << "O servidor de renderização não é suportado nesta plataforma." << std::endl;
+        return 1;
+#endif
+    }
+
+    Scene scene = defaultScene();
+    if (!scenePath.empty()) {
+        auto loadStart = std::chrono::steady_clock::now();
+        scene = Scene();
+        std::string error;
+        bool loaded = isSceneCacheFile(scenePath) ? loadSceneCache(scenePath, scene, error, verifyChecksums)
+                                                  : loadScene(scenePath, scene, error);
+        if (!loaded) {
+            std::cout << "Erro ao carregar a cena: " << error << std::endl;
+            return 1;
+        }
+        std::cout << "Cena carregada em "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count()
+                  << " ms (" << scene.sphereView().size() << " esferas, " << scene.planeView().size() << " planos)." << std::endl;
+    }
+
+    if (!convertPath.empty()) {
+        std::string error;
+        if (!writeSceneCache(scene, convertPath, error)) {
+            std::cout << "Erro ao converter a cena: " << error << std::endl;
+            return 1;
+        }
+        std::cout << "Cache binário da cena salvo em " << convertPath << std::endl;
+        return 0;
+    }
+    if (scene.sphereView().size() >= BVH_MIN_SPHERES) {
+        auto bvhStart = std::chrono::steady_clock::now();
+        bool cached = prepareSceneBVH(scene, bvhCacheDir);
+        std::cout << (cached ? "BVH mapeada do cache em " : "BVH construída em ")
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - bvhStart).count()
+                  << " ms (" << scene.bvh->nodes.size() << " nós)." << std::endl;
+    }
+    if (width > 0) scene.camera.hres = width;
+    if (height > 0) scene.camera.vres = height;
+    if (aperture >= 0) scene.camera.aperture = aperture;
+    if (focusDistance > 0) scene.camera.focusDistance = focusDistance;
+    scene.camera.projection = projection;
+    if (scene.camera.hres < 1 || scene.camera.vres < 1 || scene.camera.hres > MAX_IMAGE_DIMENSION ||
+        scene.camera.vres > MAX_IMAGE_DIMENSION) {
+        std::cout << "Resolução inválida: " << scene.camera.hres << "x" << scene.camera.vres << " (máximo "
+                  << MAX_IMAGE_DIMENSION << " por lado)" << std::endl;
+        return 1;
+    }
+    if (projection == Projection::CubeMap) {
+        if (width > 0 && width != 6 * scene.camera.vres) {
+            std::cout << "Aviso: o cube map tem 6 faces de altura x altura; largura " << width << " ignorada, usando "
+                      << 6 * scene.camera.vres << "." << std::endl;
+        }
+        scene.camera.hres = 6 * scene.camera.vres;
+    }
+    const Camera& camera = scene.camera;
+
+    if (!benchmarkName.empty()) {
+        ThreadPool pool(threads);
+        return runBenchmark(benchmarkName, scene, camera, pool) ? 0 : 1;
+    }
+
+    if (workerPort > 0) {
+#ifndef _WIN32
+        std::cout << "Worker de tiles escutando na porta " << workerPort << "..." << std::endl;
+        TileRenderFn renderTile = [&](const Tile& tile, std::vector<unsigned char>& pixels) {
+            renderTileRGBA(scene, camera, settings, tile, pixels);
+        };
+        if (serveTileWorker(workerPort, renderTile) != 0) {
+            std::cout << "Não foi possível escutar na porta " << workerPort << std::endl;
+            return 1;
+        }
+        return 0;
+#else
+        std::cout << "Workers TCP não são suportados nesta plataforma." << std::endl;
+        return 1;
+#endif
+    }
+
+    if (!viewsPath.empty() || turntableViews > 0) {
+        std::vector<Camera> cameras;
+        std::string error;
+        if (!viewsPath.empty() && !loadViews(viewsPath, camera, cameras, error)) {
+            std::cout << "Erro ao carregar as vistas: " << error << std::endl;
+            return 1;
+        }
+        if (turntableViews > 0) {
+            std::vector<Camera> orbit = turntableCameras(camera, turntableViews);
+            cameras.insert(cameras.end(), orbit.begin(), orbit.end());
+        }
+        std::string pattern = outputPath.find('%') != std::string::npos ? outputPath : "view_%03d.png";
+        ThreadPool pool(threads);
+        std::vector<std::vector<unsigned char>> images;
+        std::cout << "Renderizando " << cameras.size() << " vistas..." << std::endl;
+        auto start = std::chrono::steady_clock::now();
+        renderViews(scene, cameras, settings, pool, images);
+        double renderMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::vector<char> written(cameras.size(), 0);
+        pool.parallelFor(int(cameras.size()), [&](int v) {
+            written[v] = writeImageFile(numberedPath(pattern, v), images[v], cameras[v].hres, cameras[v].vres, compression, &pool);
+        });
+        std::cout << "Vistas renderizadas em " << renderMs << " ms (" << renderMs / cameras.size() << " ms por vista)." << std::endl;
+        return std::count(written.begin(), written.end(), 0) == 0 ? 0 : 1;
+    }
+
+    if (!animationPath.empty()) {
+        Animation animation;
+        std::string error;
+        if (!animation.load(animationPath, error)) {
+            std::cout << "Erro ao carregar a animação: " << error << std::endl;
+            return 1;
+        }
+        AnimationSettings animationSettings;
+        if (outputPath.find('%') != std::string::npos) animationSettings.outputPattern = outputPath;
+        animationSettings.inFlightFrames = inFlightFrames;
+        animationSettings.compression = compression;
+        ThreadPool pool(threads);
+        AnimationRenderer animationRenderer;
+        std::cout << "Renderizando " << animation.frameCount << " quadros..." << std::endl;
+        auto start = std::chrono::steady_clock::now();
+        bool ok = animationRenderer.render(scene, camera, settings, animation, animationSettings, pool);
+        double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Animação concluída em " << totalMs << " ms (" << animation.frameCount * 1000.0 / totalMs
+                  << " quadros/s; renderização " << animationRenderer.renderMilliseconds << " ms, codificação e escrita "
+                  << animationRenderer.encodeMilliseconds << " ms somados)." << std::endl;
+        return ok ? 0 : 1;
+    }
+
+    // Um pool para a renderização da imagem única e para a codificação: filtragem das linhas do PNG,
+    // faixas do QOI e tone mapping
+    ThreadPool pool(threads);
+    std::vector<unsigned char> image(size_t(camera.hres) * camera.vres * 4);
+    std::vector<float> hdrImage;
+    if (nudgeSphere >= 0) {
+        if (nudgeSphere >= int(scene.sphereView().size())) {
+            std::cout << "Esfera inexistente: " << nudgeSphere << std::endl;
+            return 1;
+        }
+        // Cena mapeada é somente leitura: copia para os vetores antes de editar
+        if (scene.mapping) {
+            scene.spheres.assign(scene.mappedSpheres.begin(), scene.mappedSpheres.end());
+            scene.planes.assign(scene.mappedPlanes.begin(), scene.mappedPlanes.end());
+            scene.lights.assign(scene.mappedLights.begin(), scene.mappedLights.end());
+            scene.mapping = nullptr;
+        }
+        IncrementalRenderer incremental;
+        auto start = std::chrono::steady_clock::now();
+        incremental.render(scene, camera, settings, pool);
+        double fullMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        Sphere& sphere = scene.spheres[nudgeSphere];
+        sphere.center = Point3(sphere.center.x + nudge[0], sphere.center.y + nudge[1], sphere.center.z + nudge[2]);
+        if (scene.bvh) prepareSceneBVH(scene, "");
+        start = std::chrono::steady_clock::now();
+        incremental.render(scene, camera, settings, pool);
+        double updateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Quadro completo em " << fullMs << " ms; após mover a esfera " << nudgeSphere << ", "
+                  << incremental.lastTilesRendered << " de " << incremental.lastTileCount << " tiles re-renderizados em "
+                  << updateMs << " ms." << std::endl;
+        image = incremental.image;
+    } else if (hdrOutput) {
+        auto start = std::chrono::steady_clock::now();
+        renderImageHDR(scene, camera, settings, pool, hdrImage);
+        std::cout << "Imagem HDR " << camera.hres << "x" << camera.vres << " renderizada em "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms." << std::endl;
+    } else if (camera.projection != Projection::Perspective) {
+        // Panoramas, inclusive as seis faces do cube map, saem de um único parallelFor de tiles, ou dos
+        // workers distribuídos como a imagem em perspectiva
+        auto start = std::chrono::steady_clock::now();
+        if (distributed) renderImage(scene, camera, settings, image, &pool);
+        else renderImageParallel(scene, camera, settings, pool, image);
+        std::cout << "Panorama " << camera.hres << "x" << camera.vres << " renderizado em "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms." << std::endl;
     } else {
-        std::cout << "Imagem PNG salva com sucesso." << std::endl;
+        renderImage(scene, camera, settings, image, &pool);
     }
 
-    std::cout << "Salvando a imagem em formato PPM..." << std::endl;
-    // Salva a imagem em formato PPM
-    std::ofstream ppm("output.ppm");
-    if (ppm.is_open()) {
-        ppm << "P3\n" << camera.hres << " " << camera.vres << "\n255\n";
-        for (int y = 0; y < camera.vres; ++y) {
-            for (int x = 0; x < camera.hres; ++x) {
-                int index = 4 * (y * camera.hres + x);
-                int ir = static_cast<int>(image[index]);
-                int ig = static_cast<int>(image[index + 1]);
-                int ib = static_cast<int>(image[index + 2]);
-                ppm << ir << ' ' << ig << ' ' << ib << '\n';
+    if (hdrOutput && !endsWith(outputPath, ".pfm")) toneMapRGBA8(hdrImage, camera.hres, camera.vres, toneMap, image, &pool);
+    bool ok = true;
+    if (camera.projection == Projection::CubeMap && outputPath.find('%') != std::string::npos) {
+        int face = camera.vres;
+        size_t rowBytes = size_t(face) * 4;
+        for (int f = 0; f < 6; ++f) {
+            std::vector<unsigned char> pixels(rowBytes * face);
+            for (int y = 0; y < face; ++y) {
+                std::memcpy(&pixels[y * rowBytes], &image[(size_t(y) * camera.hres + size_t(f) * face) * 4], rowBytes);
             }
+            ok = writeImageFile(numberedPath(outputPath, f), pixels, face, face, compression, &pool) && ok;
         }
-        ppm.close();
-        std::cout << "Imagem PPM salva com sucesso." << std::endl;
+    } else if (outputPath.empty()) {
+        if (bitDepth == 16) ok = savePNG16("output.png", hdrImage, camera.hres, camera.vres, toneMap, compression, pool);
+        else ok = savePNG("output.png", image, camera.hres, camera.vres, compression, pool);
+        ok = savePPM("output.ppm", image, camera.hres, camera.vres) && ok;
+    } else if (endsWith(outputPath, ".pfm")) {
+        ok = savePFM(outputPath, hdrImage, camera.hres, camera.vres);
+    } else if (endsWith(outputPath, ".ppm")) {
+        ok = savePPM(outputPath, image, camera.hres, camera.vres);
+    } else if (endsWith(outputPath, ".qoi")) {
+        ok = saveQOI(outputPath, image, camera.hres, camera.vres, pool);
+    } else if (bitDepth == 16) {
+        ok = savePNG16(outputPath, hdrImage, camera.hres, camera.vres, toneMap, compression, pool);
     } else {
-        std::cout << "Erro ao abrir o arquivo PPM para escrita." << std::endl;
+        ok = savePNG(outputPath, image, camera.hres, camera.vres, compression, pool);
     }
 
-    return 0;
+    return ok ? 0 : 1;
 }
@@ -20,7 +20,7 @@ public:
             Vec3 p0l0(point.x - ray.origin.x, point.y - ray.origin.y, point.z - ray.origin.z);
             double t = p0l0.dot(normal) / denom;
             if (t >= 0) {
-                intersection = Intersection(t, color);
+                intersection = Intersection(t, color, normal);
                 return true;
             }
         }
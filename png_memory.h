@@ -0,0 +1,119 @@
+#ifndef PNG_MEMORY_H
+#define PNG_MEMORY_H
+
+#include <cstdlib>
+#include <cstring>
+#include "lodepng.h"
+
+// Memória do lodepng reaproveitada entre imagens. Os blocos têm tamanhos de potência de dois e,
+// liberados, voltam para a lista da sua classe; realloc dentro da capacidade do bloco não move nada.
+// Codificando imagens do mesmo tamanho, a partir da segunda não há mais alocações no heap.
+// Não é sincronizado: um pool por thread de codificação, ativado com PNGAllocatorScope.
+class PNGMemoryPool {
+public:
+    PNGMemoryPool() {
+        allocator.allocate = [](size_t size, void* pool) { return static_cast<PNGMemoryPool*>(pool)->allocate(size); };
+        allocator.reallocate = [](void* ptr, size_t size, void* pool) {
+            return static_cast<PNGMemoryPool*>(pool)->reallocate(ptr, size);
+        };
+        allocator.release = [](void* ptr, void* pool) { static_cast<PNGMemoryPool*>(pool)->release(ptr); };
+        allocator.context = this;
+    }
+
+    PNGMemoryPool(const PNGMemoryPool&) = delete;
+    PNGMemoryPool& operator=(const PNGMemoryPool&) = delete;
+
+    // Blocos ainda em uso no destrutor ficam perdidos: só os livres voltam ao sistema
+    ~PNGMemoryPool() {
+        for (Block*& list : freeLists) {
+            while (list) {
+                Block* next = list->next;
+                std::free(list);
+                list = next;
+            }
+        }
+    }
+
+    const LodePNGAllocator* lodepngAllocator() const { return &allocator; }
+
+    size_t heapAllocations() const { return heapCount; }  // blocos pedidos ao malloc desde a criação
+    size_t reservedBytes() const { return reserved; }
+
+    void* allocate(size_t size) {
+        int sizeClass = classFor(size);
+        if (sizeClass < 0) return nullptr;
+        Block* block = freeLists[sizeClass];
+        if (block) {
+            freeLists[sizeClass] = block->next;
+        } else {
+            block = static_cast<Block*>(std::malloc(size_t(1) << sizeClass));
+            if (!block) return nullptr;
+            ++heapCount;
+            reserved += size_t(1) << sizeClass;
+        }
+        block->sizeClass = sizeClass;
+        return block + 1;
+    }
+
+    void* reallocate(void* ptr, size_t size) {
+        if (!ptr) return allocate(size);
+        Block* block = static_cast<Block*>(ptr) - 1;
+        size_t capacity = (size_t(1) << block->sizeClass) - sizeof(Block);
+        if (size <= capacity) return ptr;
+        void* moved = allocate(size);
+        if (!moved) return nullptr;  // como realloc, o bloco antigo continua válido
+        std::memcpy(moved, ptr, capacity);
+        release(ptr);
+        return moved;
+    }
+
+    void release(void* ptr) {
+        if (!ptr) return;
+        Block* block = static_cast<Block*>(ptr) - 1;
+        int sizeClass = block->sizeClass;  // next ocupa o mesmo lugar
+        block->next = freeLists[sizeClass];
+        freeLists[sizeClass] = block;
+    }
+
+private:
+    // Cabeçalho de 16 bytes antes de cada bloco: os dados ficam alinhados como os do malloc
+    union Block {
+        int sizeClass;        // em uso: log2 do tamanho com o cabeçalho
+        Block* next;          // livre: próximo bloco da mesma classe
+        unsigned char padding[16];
+    };
+
+    static const int minClass = 6;
+    static const int classCount = 8 * sizeof(size_t) - 1;
+
+    static int classFor(size_t size) {
+        if (size > (size_t(1) << (classCount - 1)) - sizeof(Block)) return -1;
+        int sizeClass = minClass;
+        while ((size_t(1) << sizeClass) - sizeof(Block) < size) ++sizeClass;
+        return sizeClass;
+    }
+
+    LodePNGAllocator allocator;
+    Block* freeLists[classCount] = {};
+    size_t heapCount = 0;
+    size_t reserved = 0;
+};
+
+// Enquanto existir, o lodepng na thread atual aloca do pool; sem pool (nullptr) nada muda
+class PNGAllocatorScope {
+public:
+    explicit PNGAllocatorScope(PNGMemoryPool* pool)
+        : previous(pool ? lodepng_set_thread_allocator(pool->lodepngAllocator()) : nullptr), active(pool != nullptr) {}
+    ~PNGAllocatorScope() {
+        if (active) lodepng_set_thread_allocator(previous);
+    }
+
+    PNGAllocatorScope(const PNGAllocatorScope&) = delete;
+    PNGAllocatorScope& operator=(const PNGAllocatorScope&) = delete;
+
+private:
+    const LodePNGAllocator* previous;
+    bool active;
+};
+
+#endif // PNG_MEMORY_H
@@ -0,0 +1,190 @@
+#ifndef QOI_H
+#define QOI_H
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include "thread_pool.h"
+
+// QOI, "Quite OK Image" (qoiformat.org): sem perdas, uma passada pelos pixels e sem codificação de
+// entropia. Codifica dezenas de vezes mais rápido que o deflate do PNG, com arquivos maiores; serve
+// para quadros intermediários que vão ser lidos de novo pelo pipeline.
+namespace qoi {
+
+const unsigned char OP_INDEX = 0x00;  // 00iiiiii: pixel na posição i do índice
+const unsigned char OP_DIFF = 0x40;   // 01rrggbb: diferença de -2..1 por canal
+const unsigned char OP_LUMA = 0x80;   // 10gggggg rrrrbbbb: verde -32..31, vermelho e azul relativos ao verde
+const unsigned char OP_RUN = 0xc0;    // 11llllll: repete o pixel anterior 1..62 vezes
+const unsigned char OP_RGB = 0xfe;
+const unsigned char OP_RGBA = 0xff;
+
+const size_t headerSize = 14;
+const unsigned char endMarker[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+const size_t maxPixels = 400000000;  // o mesmo limite do decodificador de referência
+const unsigned char startPixel[4] = { 0, 0, 0, 255 };
+
+inline int hashSlot(const unsigned char* p) {
+    return (p[0] * 3 + p[1] * 5 + p[2] * 7 + p[3] * 11) % 64;
+}
+
+// Codifica os pixels [begin, end) do buffer RGBA8 a partir do estado em que o decodificador chega a
+// begin: o pixel anterior é o último antes do trecho, e do índice só valem as posições escritas pelo
+// próprio trecho. Assim trechos codificados em paralelo, concatenados, formam um único QOI válido.
+// out precisa de 5 bytes por pixel; devolve o fim do que foi escrito.
+inline unsigned char* encodeSpan(const unsigned char* image, size_t begin, size_t end, unsigned char* out) {
+    uint32_t index[64];
+    uint64_t written = 0;  // posições do índice já escritas neste trecho
+    int run = 0;
+    for (size_t i = begin; i < end; ++i) {
+        const unsigned char* p = image + 4 * i;
+        const unsigned char* previous = i == 0 ? startPixel : p - 4;
+        uint32_t pixel;
+        std::memcpy(&pixel, p, 4);
+        if (std::memcmp(p, previous, 4) == 0) {
+            if (++run == 62) {
+                *out++ = OP_RUN | 61;
+                run = 0;
+            }
+            continue;
+        }
+        if (run) {
+            *out++ = static_cast<unsigned char>(OP_RUN | (run - 1));
+            run = 0;
+        }
+        int slot = hashSlot(p);
+        if ((written >> slot) & 1 && index[slot] == pixel) {
+            *out++ = static_cast<unsigned char>(OP_INDEX | slot);
+            continue;
+        }
+        index[slot] = pixel;
+        written |= uint64_t(1) << slot;
+        if (p[3] != previous[3]) {
+            out[0] = OP_RGBA;
+            std::memcpy(out + 1, p, 4);
+            out += 5;
+            continue;
+        }
+        int dr = int8_t(p[0] - previous[0]);
+        int dg = int8_t(p[1] - previous[1]);
+        int db = int8_t(p[2] - previous[2]);
+        int drg = dr - dg, dbg = db - dg;
+        if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+            *out++ = static_cast<unsigned char>(OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+        } else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7) {
+            out[0] = static_cast<unsigned char>(OP_LUMA | (dg + 32));
+            out[1] = static_cast<unsigned char>((drg + 8) << 4 | (dbg + 8));
+            out += 2;
+        } else {
+            out[0] = OP_RGB;
+            std::memcpy(out + 1, p, 3);
+            out += 4;
+        }
+    }
+    if (run) *out++ = static_cast<unsigned char>(OP_RUN | (run - 1));
+    return out;
+}
+
+inline void put32(unsigned char* out, uint32_t value) {
+    out[0] = static_cast<unsigned char>(value >> 24);
+    out[1] = static_cast<unsigned char>(value >> 16);
+    out[2] = static_cast<unsigned char>(value >> 8);
+    out[3] = static_cast<unsigned char>(value);
+}
+
+inline uint32_t get32(const unsigned char* in) {
+    return uint32_t(in[0]) << 24 | uint32_t(in[1]) << 16 | uint32_t(in[2]) << 8 | in[3];
+}
+
+} // namespace qoi
+
+// QOI a partir do buffer RGBA8. Como no PNG, o arquivo é declarado RGB (o renderizador sempre grava
+// alfa 255); um alfa diferente ainda é codificado, o campo de canais é só informativo.
+// Com pool, faixas de linhas são codificadas em paralelo e emendadas: o arquivo fica alguns bytes
+// maior que o serial, porque cada faixa começa com o índice vazio.
+inline void encodeQOI(const std::vector<unsigned char>& image, int width, int height, std::vector<unsigned char>& out,
+                      ThreadPool* pool = nullptr) {
+    size_t pixels = size_t(width) * height;
+    int strips = pool ? std::max(1, std::min(pool->size() * 2, height / 32)) : 1;
+    int rowsPerStrip = (height + strips - 1) / strips;
+    // Cada faixa escreve no pior caso reservado para ela; páginas não usadas nem chegam a ser tocadas
+    std::unique_ptr<unsigned char[]> buffer(new unsigned char[pixels * 5 + 1]);
+    std::vector<size_t> sizes(strips);
+    auto encodeStrip = [&](int strip) {
+        size_t begin = std::min(size_t(strip) * rowsPerStrip, size_t(height)) * width;
+        size_t end = std::min(size_t(strip + 1) * rowsPerStrip, size_t(height)) * width;
+        unsigned char* start = buffer.get() + begin * 5;
+        sizes[strip] = qoi::encodeSpan(image.data(), begin, end, start) - start;
+    };
+    if (strips > 1) pool->parallelFor(strips, encodeStrip);
+    else encodeStrip(0);
+
+    size_t total = qoi::headerSize + sizeof(qoi::endMarker);
+    for (size_t size : sizes) total += size;
+    out.resize(total);
+    unsigned char* p = out.data();
+    std::memcpy(p, "qoif", 4);
+    qoi::put32(p + 4, uint32_t(width));
+    qoi::put32(p + 8, uint32_t(height));
+    p[12] = 3;  // canais
+    p[13] = 0;  // sRGB com alfa linear
+    p += qoi::headerSize;
+    for (int strip = 0; strip < strips; ++strip) {
+        size_t begin = std::min(size_t(strip) * rowsPerStrip, size_t(height)) * width;
+        std::memcpy(p, buffer.get() + begin * 5, sizes[strip]);
+        p += sizes[strip];
+    }
+    std::memcpy(p, qoi::endMarker, sizeof(qoi::endMarker));
+}
+
+// Decodifica um QOI para RGBA8, qualquer que seja o campo de canais. Falha em cabeçalho inválido ou
+// dados truncados.
+inline bool decodeQOI(const unsigned char* data, size_t size, std::vector<unsigned char>& image, int& width, int& height) {
+    if (size < qoi::headerSize + sizeof(qoi::endMarker) || std::memcmp(data, "qoif", 4) != 0) return false;
+    uint32_t w = qoi::get32(data + 4), h = qoi::get32(data + 8);
+    if (w == 0 || h == 0 || data[12] < 3 || data[12] > 4 || data[13] > 1 || h >= qoi::maxPixels / w) return false;
+    width = int(w);
+    height = int(h);
+    size_t pixels = size_t(w) * h;
+    image.resize(pixels * 4);
+
+    unsigned char index[64][4] = {};
+    unsigned char pixel[4] = { 0, 0, 0, 255 };
+    const unsigned char* p = data + qoi::headerSize;
+    const unsigned char* end = data + size - sizeof(qoi::endMarker);
+    unsigned char* outPixel = image.data();
+    size_t i = 0;
+    while (i < pixels) {
+        if (p >= end) return false;
+        unsigned char op = *p++;
+        size_t count = 1;
+        if (op == qoi::OP_RGB || op == qoi::OP_RGBA) {
+            size_t channels = op == qoi::OP_RGB ? 3 : 4;
+            if (size_t(end - p) < channels) return false;
+            std::memcpy(pixel, p, channels);
+            p += channels;
+        } else if ((op & 0xc0) == qoi::OP_INDEX) {
+            std::memcpy(pixel, index[op], 4);
+        } else if ((op & 0xc0) == qoi::OP_DIFF) {
+            pixel[0] = static_cast<unsigned char>(pixel[0] + ((op >> 4) & 3) - 2);
+            pixel[1] = static_cast<unsigned char>(pixel[1] + ((op >> 2) & 3) - 2);
+            pixel[2] = static_cast<unsigned char>(pixel[2] + (op & 3) - 2);
+        } else if ((op & 0xc0) == qoi::OP_LUMA) {
+            if (p >= end) return false;
+            int dg = (op & 0x3f) - 32;
+            unsigned char next = *p++;
+            pixel[0] = static_cast<unsigned char>(pixel[0] + dg - 8 + (next >> 4));
+            pixel[1] = static_cast<unsigned char>(pixel[1] + dg);
+            pixel[2] = static_cast<unsigned char>(pixel[2] + dg - 8 + (next & 15));
+        } else {
+            count = std::min(size_t(op & 0x3f) + 1, pixels - i);
+        }
+        std::memcpy(index[qoi::hashSlot(pixel)], pixel, 4);
+        for (size_t k = 0; k < count; ++k, outPixel += 4) std::memcpy(outPixel, pixel, 4);
+        i += count;
+    }
+    return true;
+}
+
+#endif // QOI_H
@@ -8,8 +8,9 @@ class Ray {
 public:
     Point3 origin;
     Vec3 direction;
+    double time; // instante dentro do obturador, em [0, 1)
 
-    Ray(Point3 o, Vec3 d) : origin(o), direction(d) {}
+    Ray(Point3 o, Vec3 d, double t = 0.0) : origin(o), direction(d), time(t) {}
 };
 
 #endif // RAY_H
@@ -0,0 +1,80 @@
+// Cliente de linha de comando do servidor de renderização (main --server <socket>).
+//   render_client <socket> [-o arquivo] [chave=valor ...]
+//   render_client <socket> stats
+//   render_client <socket> shutdown
+// Compilar: g++ -std=c++17 -O2 render_client.cpp -o render_client
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <climits>
+#include "render_protocol.h"
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cout << "Uso: " << argv[0] << " <socket> [-o arquivo] [chave=valor ...] | stats | shutdown\n"
+                  << "Chaves: scene, resolution (LxA), width, height, sampling, spp, denoise, format (png|ppm|qoi),\n"
+                  << "        camera (px,py,pz,alvox,alvoy,alvoz,upx,upy,upz), aperture, focus,\n"
+                  << "        projection (perspective|equirect|cubemap), compression (store|huffman|rle|fast|default|max)\n";
+        return 1;
+    }
+
+    std::string outputPath;
+    std::string request;
+    std::string format = "png";
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "-o" || arg == "--output") && i + 1 < argc) {
+            outputPath = argv[++i];
+            continue;
+        }
+        if (arg.compare(0, 7, "format=") == 0) format = arg.substr(7);
+        // O servidor roda em outro diretório: caminhos de cena vão absolutos
+        char resolved[PATH_MAX];
+        if (arg.compare(0, 6, "scene=") == 0 && arg.size() > 6 && realpath(arg.c_str() + 6, resolved)) {
+            arg = std::string("scene=") + resolved;
+        }
+        if (!request.empty()) request += ' ';
+        request += arg;
+    }
+    bool textReply = request == "stats" || request == "shutdown";
+    if (outputPath.empty()) outputPath = "output." + format;
+
+    int fd = net::connectUnix(argv[1]);
+    if (fd < 0) {
+        std::cout << "Não foi possível conectar a " << argv[1] << std::endl;
+        return 1;
+    }
+    request += '\n';
+    net::JobReplyHeader header;
+    std::vector<char> payload;
+    bool ok = net::writeAll(fd, request.data(), request.size()) && net::readAll(fd, &header, sizeof(header)) &&
+              header.type == net::JOB_RESULT;
+    if (ok) {
+        payload.resize(size_t(header.size));
+        ok = net::readAll(fd, payload.data(), payload.size());
+    }
+    close(fd);
+    if (!ok) {
+        std::cout << "Resposta incompleta do servidor." << std::endl;
+        return 1;
+    }
+
+    if (header.status != net::JOB_OK) {
+        std::cout << "Erro do servidor: " << std::string(payload.begin(), payload.end()) << std::endl;
+        return 1;
+    }
+    if (textReply) {
+        std::cout << std::string(payload.begin(), payload.end()) << std::endl;
+        return 0;
+    }
+    std::ofstream file(outputPath, std::ios::binary);
+    file.write(payload.data(), std::streamsize(payload.size()));
+    if (!file) {
+        std::cout << "Erro ao gravar " << outputPath << std::endl;
+        return 1;
+    }
+    std::cout << "Imagem salva em " << outputPath << " (" << payload.size() << " bytes)." << std::endl;
+    return 0;
+}
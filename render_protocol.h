@@ -0,0 +1,83 @@
+#ifndef RENDER_PROTOCOL_H
+#define RENDER_PROTOCOL_H
+
+// Protocolo entre o servidor de renderização (render_server.h) e o cliente (render_client.cpp).
+// Pedido: uma linha de texto com pares chave=valor separados por espaço, terminada em '\n', ex.
+//   scene=scenes/lights.txt resolution=800x600 sampling=edge format=png
+// Resposta: JobReplyHeader seguido de size bytes, a imagem codificada ou a mensagem de erro.
+#ifndef _WIN32
+
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <sys/un.h>
+#include "distributed.h"
+
+namespace net {
+
+const uint32_t JOB_RESULT = 0x544c5352; // "RSLT"
+const uint32_t JOB_OK = 0;
+const uint32_t JOB_ERROR = 1;
+const size_t MAX_REQUEST_LINE = 4096;
+
+struct JobReplyHeader {
+    uint32_t type;
+    uint32_t status;
+    uint64_t size;
+};
+
+inline bool makeUnixAddress(const std::string& path, sockaddr_un& addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) return false;
+    std::memcpy(addr.sun_path, path.c_str(), path.size());
+    return true;
+}
+
+inline int connectUnix(const std::string& path) {
+    sockaddr_un addr;
+    if (!makeUnixAddress(path, addr)) return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Um socket deixado por um servidor anterior que morreu é removido antes do bind
+inline int listenUnix(const std::string& path) {
+    sockaddr_un addr;
+    if (!makeUnixAddress(path, addr)) return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    unlink(path.c_str());
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 64) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Lê até '\n' (não incluído); falha em conexão fechada, timeout ou linha longa demais. Com
+// timeoutMs > 0, a linha inteira precisa chegar nesse prazo, não só cada byte.
+inline bool readLine(int fd, std::string& line, int timeoutMs = 0) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    line.clear();
+    char c;
+    while (line.size() < MAX_REQUEST_LINE) {
+        if (!readAll(fd, &c, 1)) return false;
+        if (c == '\n') return true;
+        line += c;
+        if (timeoutMs > 0 && std::chrono::steady_clock::now() > deadline) return false;
+    }
+    return false;
+}
+
+} // namespace net
+
+#endif // _WIN32
+
+#endif // RENDER_PROTOCOL_H
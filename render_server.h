@@ -0,0 +1,394 @@
+#ifndef RENDER_SERVER_H
+#define RENDER_SERVER_H
+
+// Servidor de renderização de longa duração (somente POSIX): aceita pedidos num socket Unix,
+// mantém as cenas usadas recentemente em memória e renderiza os tiles num pool compartilhado
+#ifndef _WIN32
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstdio>
+#include <csignal>
+#include <poll.h>
+#include <sys/stat.h>
+#include "scene.h"
+#include "scene_cache.h"
+#include "renderer.h"
+#include "framebuffer.h"
+#include "render_protocol.h"
+#include "lodepng.h"
+
+class RenderServerSettings {
+public:
+    std::string socketPath;
+    int threads = 0;             // threads do pool de tiles, 0 = uma por núcleo
+    int concurrentJobs = 2;      // jobs em andamento ao mesmo tempo; os tiles deles se intercalam no pool
+    size_t residentScenes = 4;   // cenas mantidas em memória (LRU)
+    int requestTimeoutMs = 5000; // um cliente que não termina de mandar o pedido é descartado
+    int replyTimeoutMs = 10000;  // um cliente que para de ler a resposta por esse tempo também
+    std::string bvhCacheDir;
+};
+
+const int MAX_JOB_DIMENSION = MAX_IMAGE_DIMENSION;  // largura ou altura máxima de um job, em pixels
+
+class JobRequest {
+public:
+    std::string scenePath;  // vazio = cena embutida
+    std::string format = "png";
+    LodePNGCompressionPreset compression = LCP_DEFAULT;
+    int width = 0, height = 0;
+    bool hasCamera = false;
+    double camera[9];       // posição, alvo e vetor up
+    double aperture = -1;   // < 0 mantém a lente da cena
+    double focusDistance = -1;
+    Projection projection = Projection::Perspective;
+    RenderSettings settings;
+
+    JobRequest() { settings.heatmapPath.clear(); }
+};
+
+inline bool parseJobRequest(const std::string& line, JobRequest& job, std::string& error) {
+    std::istringstream tokens(line);
+    std::string token;
+    while (tokens >> token) {
+        size_t eq = token.find('=');
+        if (eq == std::string::npos) {
+            error = "esperado chave=valor: " + token;
+            return false;
+        }
+        std::string key = token.substr(0, eq), value = token.substr(eq + 1);
+        if (key == "scene") {
+            job.scenePath = value;
+        } else if (key == "format") {
+            if (value != "png" && value != "ppm" && value != "qoi") {
+                error = "formato desconhecido: " + value;
+                return false;
+            }
+            job.format = value;
+        } else if (key == "compression") {
+            if (!parseCompressionPreset(value, job.compression)) {
+                error = "preset de compressão desconhecido: " + value;
+                return false;
+            }
+        } else if (key == "width") {
+            job.width = std::atoi(value.c_str());
+        } else if (key == "height") {
+            job.height = std::atoi(value.c_str());
+        } else if (key == "resolution") {
+            if (std::sscanf(value.c_str(), "%dx%d", &job.width, &job.height) != 2) {
+                error = "resolução inválida: " + value;
+                return false;
+            }
+        } else if (key == "camera") {
+            double* c = job.camera;
+            if (std::sscanf(value.c_str(), "%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf", c, c + 1, c + 2, c + 3, c + 4, c + 5,
+                            c + 6, c + 7, c + 8) != 9) {
+                error = "câmera espera 9 números separados por vírgula: " + value;
+                return false;
+            }
+            job.hasCamera = true;
+        } else if (key == "aperture") {
+            job.aperture = std::max(0.0, std::atof(value.c_str()));
+        } else if (key == "focus") {
+            job.focusDistance = std::atof(value.c_str());
+            if (job.focusDistance <= 0) {
+                error = "distância de foco deve ser positiva";
+                return false;
+            }
+        } else if (key == "projection") {
+            if (!parseProjection(value, job.projection)) {
+                error = "projeção desconhecida: " + value;
+                return false;
+            }
+        } else if (key == "sampling") {
+            if (value == "center") job.settings.samplingMode = SamplingMode::PixelCenter;
+            else if (value == "variance") job.settings.samplingMode = SamplingMode::VarianceAdaptive;
+            else if (value == "edge") job.settings.samplingMode = SamplingMode::EdgeAdaptive;
+            else {
+                error = "modo de amostragem desconhecido: " + value;
+                return false;
+            }
+        } else if (key == "spp") {
+            job.settings.adaptiveSettings.maxSamples = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "denoise") {
+            job.settings.denoise = value == "1" || value == "true";
+        } else {
+            error = "chave desconhecida: " + key;
+            return false;
+        }
+    }
+    if (job.width < 0 || job.height < 0 || job.width > MAX_JOB_DIMENSION || job.height > MAX_JOB_DIMENSION) {
+        error = "resolução fora do limite";
+        return false;
+    }
+    // O cube map tem 6 faces de altura x altura: a largura vem da altura
+    if (job.projection == Projection::CubeMap && job.width > 0 && job.width != 6 * job.height) {
+        error = "cubemap: a largura é 6 x altura; informe só height";
+        return false;
+    }
+    return true;
+}
+
+// Cenas residentes com descarte da menos usada. Um arquivo alterado no disco (mtime ou tamanho)
+// é recarregado. Jobs seguram um shared_ptr, então descartar uma cena em uso é seguro.
+class ResidentScenes {
+public:
+    std::atomic<long long> hits{ 0 }, misses{ 0 };
+
+    ResidentScenes(size_t capacity, const std::string& bvhCacheDir) : capacity(std::max<size_t>(1, capacity)), bvhCacheDir(bvhCacheDir) {}
+
+    std::shared_ptr<const Scene> get(const std::string& path, std::string& error) {
+        long long stamp = 0, size = 0;
+        if (!path.empty()) {
+            struct stat st;
+            if (stat(path.c_str(), &st) != 0) {
+                error = "cena não encontrada: " + path;
+                return nullptr;
+            }
+            stamp = (long long)st.st_mtime;
+            size = (long long)st.st_size;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto it = entries.begin(); it != entries.end(); ++it) {
+                if (it->path != path) continue;
+                if (it->stamp == stamp && it->size == size) {
+                    entries.splice(entries.begin(), entries, it);
+                    ++hits;
+                    return entries.front().scene;
+                }
+                entries.erase(it);
+                break;
+            }
+        }
+
+        // Carrega fora da trava: outros jobs com cenas residentes não esperam
+        ++misses;
+        std::shared_ptr<Scene> scene = std::make_shared<Scene>();
+        if (path.empty()) {
+            *scene = defaultScene();
+        } else {
+            bool loaded = isSceneCacheFile(path) ? loadSceneCache(path, *scene, error) : loadScene(path, *scene, error);
+            if (!loaded) return nullptr;
+        }
+        prepareSceneBVH(*scene, bvhCacheDir);
+
+        // Outro job pode ter carregado o mesmo arquivo enquanto isso: fica a cópia que já está residente
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            if (it->path != path) continue;
+            if (it->stamp == stamp && it->size == size) {
+                entries.splice(entries.begin(), entries, it);
+                return entries.front().scene;
+            }
+            entries.erase(it);
+            break;
+        }
+        entries.push_front(Entry{ path, stamp, size, scene });
+        while (entries.size() > capacity) entries.pop_back();
+        return scene;
+    }
+
+    size_t residentCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.size();
+    }
+
+private:
+    struct Entry {
+        std::string path;
+        long long stamp, size;
+        std::shared_ptr<const Scene> scene;
+    };
+
+    size_t capacity;
+    std::string bvhCacheDir;
+    std::list<Entry> entries;
+    std::mutex mutex;
+};
+
+class RenderServer {
+public:
+    explicit RenderServer(const RenderServerSettings& settings)
+        : settings(settings), pool(settings.threads), scenes(settings.residentScenes, settings.bvhCacheDir) {}
+
+    // Atende até receber o pedido "shutdown"; os jobs já enfileirados terminam antes de retornar
+    int run() {
+        int listenFd = net::listenUnix(settings.socketPath);
+        if (listenFd < 0) return -1;
+        std::cout << "Servidor de renderização em " << settings.socketPath << " (" << pool.size() << " threads, "
+                  << settings.concurrentJobs << " jobs simultâneos)." << std::endl;
+
+        // Sem MSG_NOSIGNAL, escrever para um cliente que fechou a conexão mataria o servidor
+        std::signal(SIGPIPE, SIG_IGN);
+
+        std::vector<std::thread> runners;
+        for (int i = 0; i < std::max(1, settings.concurrentJobs); ++i) runners.emplace_back([this] { runJobs(); });
+
+        // A thread de aceite só enfileira conexões: o pedido é lido pelas threads de jobs, então um
+        // cliente parado não atrasa os outros. O poll deixa ver o shutdown pedido a uma delas.
+        while (!shutdownRequested) {
+            pollfd listening = { listenFd, POLLIN, 0 };
+            int ready = poll(&listening, 1, 100);
+            if (ready < 0 && errno != EINTR) break;
+            if (ready <= 0) continue;
+            int fd = accept(listenFd, nullptr, nullptr);
+            if (fd < 0) {
+                if (errno == EINTR || errno == EAGAIN || errno == ECONNABORTED) continue;
+                break;
+            }
+            net::setReceiveTimeout(fd, settings.requestTimeoutMs);
+            net::setSendTimeout(fd, settings.replyTimeoutMs);
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                queue.push_back(Job{ fd, ++submittedJobs });
+            }
+            queueReady.notify_one();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            stopping = true;
+        }
+        queueReady.notify_all();
+        for (auto& runner : runners) runner.join();
+        close(listenFd);
+        unlink(settings.socketPath.c_str());
+        return 0;
+    }
+
+private:
+    struct Job {
+        int fd;
+        long long id;
+    };
+
+    RenderServerSettings settings;
+    ThreadPool pool;
+    ResidentScenes scenes;
+    std::deque<Job> queue;
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    bool stopping = false;
+    std::atomic<bool> shutdownRequested{ false };
+    long long submittedJobs = 0;
+    std::atomic<long long> completedJobs{ 0 }, failedJobs{ 0 };
+
+    // Cada thread de jobs reaproveita a memória do lodepng de um PNG para o próximo
+    void runJobs() {
+        PNGMemoryPool memory;
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueReady.wait(lock, [this] { return stopping || !queue.empty(); });
+                if (queue.empty()) return;
+                job = queue.front();
+                queue.pop_front();
+            }
+            // Quem não manda o pedido inteiro em requestTimeoutMs é descartado sem resposta
+            std::string line;
+            if (net::readLine(job.fd, line, settings.requestTimeoutMs)) handleRequest(job, line, memory);
+            close(job.fd);
+        }
+    }
+
+    void handleRequest(const Job& job, const std::string& line, PNGMemoryPool& memory) {
+        if (line == "shutdown") {
+            reply(job.fd, net::JOB_OK, "encerrando");
+            shutdownRequested = true;
+        } else if (line == "stats") {
+            reply(job.fd, net::JOB_OK, stats());
+        } else {
+            runJob(job, line, memory);
+        }
+    }
+
+    void runJob(const Job& job, const std::string& line, PNGMemoryPool& memory) {
+        auto start = std::chrono::steady_clock::now();
+        JobRequest request;
+        std::string error;
+        std::shared_ptr<const Scene> scene;
+        if (parseJobRequest(line, request, error)) scene = scenes.get(request.scenePath, error);
+        if (!scene) {
+            ++failedJobs;
+            std::cout << "Job " << job.id << " recusado: " << error << std::endl;
+            reply(job.fd, net::JOB_ERROR, error);
+            return;
+        }
+
+        Camera camera = scene->camera;
+        if (request.hasCamera) {
+            const double* c = request.camera;
+            camera.position = Point3(c[0], c[1], c[2]);
+            camera.lookAt = Point3(c[3], c[4], c[5]);
+            camera.up = Vec3(c[6], c[7], c[8]);
+        }
+        if (request.aperture >= 0) camera.aperture = request.aperture;
+        if (request.focusDistance > 0) camera.focusDistance = request.focusDistance;
+        if (request.width > 0) camera.hres = request.width;
+        if (request.height > 0) camera.vres = request.height;
+        camera.projection = request.projection;
+        if (camera.projection == Projection::CubeMap) camera.hres = 6 * camera.vres;
+        if (camera.hres > MAX_JOB_DIMENSION || camera.vres > MAX_JOB_DIMENSION) {
+            ++failedJobs;
+            error = "resolução fora do limite: " + std::to_string(camera.hres) + "x" + std::to_string(camera.vres);
+            std::cout << "Job " << job.id << " recusado: " << error << std::endl;
+            reply(job.fd, net::JOB_ERROR, error);
+            return;
+        }
+
+        std::vector<unsigned char> image(size_t(camera.hres) * camera.vres * 4);
+        renderImageParallel(*scene, camera, request.settings, pool, image);
+
+        std::string encoded;
+        if (request.format == "ppm") {
+            encodePPM(image, camera.hres, camera.vres, encoded);
+        } else if (request.format == "qoi") {
+            std::vector<unsigned char> qoi;
+            encodeQOI(image, camera.hres, camera.vres, qoi, &pool);
+            encoded.assign(qoi.begin(), qoi.end());
+        } else {
+            std::vector<unsigned char> png;
+            unsigned encodeError = encodePNG(image, camera.hres, camera.vres, png, request.compression, &pool, &memory);
+            if (encodeError) {
+                ++failedJobs;
+                reply(job.fd, net::JOB_ERROR, std::string("Encoder error: ") + lodepng_error_text(encodeError));
+                return;
+            }
+            encoded.assign(png.begin(), png.end());
+        }
+        bool sent = reply(job.fd, net::JOB_OK, encoded);
+        ++completedJobs;
+        std::cout << "Job " << job.id << ": " << camera.hres << "x" << camera.vres << " em "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms"
+                  << (sent ? "" : " (cliente desconectou)") << std::endl;
+    }
+
+    std::string stats() {
+        std::ostringstream out;
+        out << "jobs=" << completedJobs << " falhas=" << failedJobs << " cenas_residentes=" << scenes.residentCount()
+            << " acertos=" << scenes.hits << " carregamentos=" << scenes.misses << " threads=" << pool.size() << "\n";
+        return out.str();
+    }
+
+    static bool reply(int fd, uint32_t status, const std::string& payload) {
+        net::JobReplyHeader header = { net::JOB_RESULT, status, payload.size() };
+        return net::writeAll(fd, &header, sizeof(header)) && net::writeAll(fd, payload.data(), payload.size());
+    }
+};
+
+#endif // _WIN32
+
+#endif // RENDER_SERVER_H
@@ -0,0 +1,410 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <limits>
+#include <cstdlib>
+#include <cstring>
+#include "ray.h"
+#include "sphere.h"
+#include "plane.h"
+#include "intersection.h"
+#include "camera.h"
+#include "scene.h"
+#include "array_view.h"
+#include "adaptive.h"
+#include "antialias.h"
+#include "denoiser.h"
+#include "distributed.h"
+#include "thread_pool.h"
+#include "lodepng.h"
+
+enum class SamplingMode {
+    PixelCenter,       // um raio pelo centro de cada pixel
+    VarianceAdaptive,  // amostras extras nos tiles ruidosos (adaptive.h)
+    EdgeAdaptive       // subdivisão apenas nos pixels de borda (antialias.h)
+};
+
+class RenderSettings {
+public:
+    SamplingMode samplingMode = SamplingMode::PixelCenter;
+    AdaptiveSettings adaptiveSettings;
+    EdgeAASettings edgeSettings;
+    int workerProcesses = 0;                  // > 0: tiles renderizados em processos filhos via sockets Unix
+    std::vector<std::string> remoteWorkers;   // workers TCP no formato host:porta
+    bool denoise = false;                     // útil com VarianceAdaptive e poucas amostras por pixel
+    DenoiseSettings denoiseSettings;
+    std::string heatmapPath = "heatmap.png";  // mapa de amostras do modo VarianceAdaptive, vazio para não salvar
+};
+
+// Instante do obturador para os modos sem sampler próprio (centro e bordas), tirado de um hash da
+// posição contínua: os cantos do anti-aliasing já dão a cada amostra um instante diferente, e as
+// regiões borradas aparecem como bordas, recebendo mais amostras. O modo adaptativo tira o tempo do
+// sampler, estratificado junto com o jitter do pixel.
+inline double shutterTime(double px, double py) {
+    uint64_t bx, by;
+    std::memcpy(&bx, &px, sizeof(bx));
+    std::memcpy(&by, &py, sizeof(by));
+    uint32_t h = sampling::hashCombine(sampling::hash(uint32_t(bx) ^ uint32_t(bx >> 32)), uint32_t(by) ^ uint32_t(by >> 32));
+    return sampling::toUnit(sampling::hash(h));
+}
+
+// Ponto na lente para os modos sem sampler próprio (centro e bordas), pelo mesmo tipo de hash
+inline void lensSample(double px, double py, double& u, double& v) {
+    uint64_t bx, by;
+    std::memcpy(&bx, &px, sizeof(bx));
+    std::memcpy(&by, &py, sizeof(by));
+    uint32_t h = sampling::hashCombine(sampling::hash(uint32_t(by) ^ uint32_t(by >> 32) ^ 0x6c656e73u), uint32_t(bx) ^ uint32_t(bx >> 32));
+    u = sampling::toUnit(sampling::hash(h));
+    v = sampling::toUnit(sampling::hashCombine(h, 1));
+}
+
+inline Ray primaryRay(const Camera& camera, double px, double py, double lensU, double lensV, double time) {
+    Ray ray = camera.getRay(px, py, lensU, lensV);
+    ray.time = time;
+    return ray;
+}
+
+inline Ray primaryRay(const Camera& camera, double px, double py, double lensU, double lensV) {
+    return primaryRay(camera, px, py, lensU, lensV, shutterTime(px, py));
+}
+
+inline Ray primaryRay(const Camera& camera, double px, double py) {
+    if (!camera.thinLens()) {
+        Ray ray = camera.getRay(px, py);
+        ray.time = shutterTime(px, py);
+        return ray;
+    }
+    double lensU, lensV;
+    lensSample(px, py, lensU, lensV);
+    return primaryRay(camera, px, py, lensU, lensV);
+}
+
+inline bool findClosestIntersection(const Ray& ray, ArrayView<Sphere> spheres, ArrayView<Plane> planes, Intersection& closestIntersection) {
+    bool hasIntersection = false;
+    double closestDistance = std::numeric_limits<double>::max();
+
+    // IDs: esferas primeiro, depois planos, na ordem dos vetores
+    for (size_t i = 0; i < spheres.size(); ++i) {
+        Intersection intersection(0, Vec3());
+        if (spheres[i].intersect(ray, intersection) && intersection.distance < closestDistance) {
+            closestDistance = intersection.distance;
+            closestIntersection = intersection;
+            closestIntersection.id = int(i);
+            hasIntersection = true;
+        }
+    }
+
+    for (size_t i = 0; i < planes.size(); ++i) {
+        Intersection intersection(0, Vec3());
+        if (planes[i].intersect(ray, intersection) && intersection.distance < closestDistance) {
+            closestDistance = intersection.distance;
+            closestIntersection = intersection;
+            closestIntersection.id = int(spheres.size() + i);
+            hasIntersection = true;
+        }
+    }
+
+    return hasIntersection;
+}
+
+// Qualquer interseção antes de maxDistance basta para o raio de sombra
+inline bool isOccluded(const Ray& ray, double maxDistance, ArrayView<Sphere> spheres, ArrayView<Plane> planes) {
+    Intersection intersection(0, Vec3());
+    for (const auto& sphere : spheres) {
+        if (sphere.intersect(ray, intersection) && intersection.distance < maxDistance) return true;
+    }
+    for (const auto& plane : planes) {
+        if (plane.intersect(ray, intersection) && intersection.distance < maxDistance) return true;
+    }
+    return false;
+}
+
+// Com BVH as esferas passam pela hierarquia e só os planos são testados um a um
+inline bool intersectScene(const Scene& scene, const Ray& ray, Intersection& hit) {
+    if (!scene.bvh) return findClosestIntersection(ray, scene.sphereView(), scene.planeView(), hit);
+    ArrayView<Sphere> spheres = scene.sphereView();
+    ArrayView<Plane> planes = scene.planeView();
+    double closestDistance = std::numeric_limits<double>::max();
+    bool hasIntersection = scene.bvh->intersect(ray, spheres, hit, closestDistance);
+    for (size_t i = 0; i < planes.size(); ++i) {
+        Intersection intersection(0, Vec3());
+        if (planes[i].intersect(ray, intersection) && intersection.distance < closestDistance) {
+            closestDistance = intersection.distance;
+            hit = intersection;
+            hit.id = int(spheres.size() + i);
+            hasIntersection = true;
+        }
+    }
+    return hasIntersection;
+}
+
+inline bool sceneOccluded(const Scene& scene, const Ray& ray, double maxDistance) {
+    if (!scene.bvh) return isOccluded(ray, maxDistance, scene.sphereView(), scene.planeView());
+    if (scene.bvh->occluded(ray, maxDistance, scene.sphereView())) return true;
+    return isOccluded(ray, maxDistance, ArrayView<Sphere>(), scene.planeView());
+}
+
+// Sem luzes na cena a cor da primitiva é usada diretamente; com luzes, ambiente + Lambert com sombras
+inline Vec3 shade(const Scene& scene, const Ray& ray, const Intersection& hit) {
+    ArrayView<Light> lights = scene.lightView();
+    if (lights.empty()) return hit.color;
+
+    Point3 p(ray.origin.x + hit.distance * ray.direction.x,
+             ray.origin.y + hit.distance * ray.direction.y,
+             ray.origin.z + hit.distance * ray.direction.z);
+    Vec3 normal = hit.normal;
+    if (normal.dot(ray.direction) > 0) normal = normal * -1.0;
+    Point3 shadowOrigin(p.x + normal.x * 1e-6, p.y + normal.y * 1e-6, p.z + normal.z * 1e-6);
+
+    Vec3 result = hit.color * scene.ambient;
+    for (const auto& light : lights) {
+        Vec3 toLight(light.position.x - p.x, light.position.y - p.y, light.position.z - p.z);
+        double lightDistance = toLight.length();
+        Vec3 l = toLight / lightDistance;
+        double lambert = normal.dot(l);
+        if (lambert <= 0) continue;
+        if (sceneOccluded(scene, Ray(shadowOrigin, l, ray.time), lightDistance)) continue;
+        result = result + hit.color * light.color * lambert;
+    }
+    return result;
+}
+
+inline Vec3 traceColor(const Scene& scene, const Ray& ray) {
+    Intersection hit(0, Vec3());
+    if (!intersectScene(scene, ray, hit)) return scene.background;
+    return shade(scene, ray, hit);
+}
+
+inline PrimarySample tracePrimary(const Scene& scene, const Ray& ray) {
+    Intersection hit(0, Vec3());
+    if (!intersectScene(scene, ray, hit)) return PrimarySample(scene.background, -1);
+    return PrimarySample(shade(scene, ray, hit), hit.id);
+}
+
+// Um raio pelo centro de cada pixel, em cores de ponto flutuante: a conversão para 8 bits (com
+// clamp) ou para HDR fica com quem chama
+inline void render(const Scene& scene, const Camera& camera, std::vector<Vec3>& colors) {
+    std::cout << "Iniciando renderização..." << std::endl;
+
+    RayRowGenerator rays(camera, 0, camera.hres);
+    std::vector<Vec3> directions;
+    for (int y = 0; y < camera.vres; ++y) {
+        if (!camera.thinLens()) rays.row(y, directions);
+        for (int x = 0; x < camera.hres; ++x) {
+            Ray ray = camera.thinLens() ? primaryRay(camera, x + 0.5, y + 0.5)
+                                        : Ray(camera.position, directions[x], shutterTime(x + 0.5, y + 0.5));
+
+            Intersection closestIntersection(0, Vec3());
+            Vec3 color = scene.background;
+            if (intersectScene(scene, ray, closestIntersection)) {
+                color = shade(scene, ray, closestIntersection);
+            }
+            colors[size_t(y) * camera.hres + x] = color;
+        }
+    }
+
+    std::cout << "Renderização concluída." << std::endl;
+}
+
+// Raio primário pelo centro de cada pixel para os buffers auxiliares do denoiser
+inline void renderGBuffer(const Scene& scene, const Camera& camera, GBuffer& gbuffer) {
+    for (int y = 0; y < camera.vres; ++y) {
+        for (int x = 0; x < camera.hres; ++x) {
+            Intersection hit(0, Vec3());
+            if (intersectScene(scene, primaryRay(camera, x + 0.5, y + 0.5), hit)) {
+                gbuffer.set(x, y, hit.normal, hit.distance, hit.color, hit.id);
+            }
+        }
+    }
+}
+
+// Cores de um tile, linha a linha. PixelCenter usa um raio por pixel; os demais modos usam o
+// anti-aliasing adaptativo de bordas.
+inline void renderTileColors(const Scene& scene, const Camera& camera, const RenderSettings& settings, const Tile& tile,
+                             std::vector<Vec3>& tileColors) {
+    int tileWidth = tile.x1 - tile.x0;
+    tileColors.assign(size_t(tileWidth) * (tile.y1 - tile.y0), Vec3());
+    if (settings.samplingMode == SamplingMode::PixelCenter && !camera.thinLens()) {
+        RayRowGenerator rays(camera, tile.x0, tile.x1);
+        std::vector<Vec3> directions;
+        for (int y = tile.y0; y < tile.y1; ++y) {
+            rays.row(y, directions);
+            for (int x = tile.x0; x < tile.x1; ++x) {
+                Ray ray(camera.position, directions[x - tile.x0], shutterTime(x + 0.5, y + 0.5));
+                tileColors[(y - tile.y0) * tileWidth + (x - tile.x0)] = traceColor(scene, ray);
+            }
+        }
+    } else if (settings.samplingMode == SamplingMode::PixelCenter) {
+        for (int y = tile.y0; y < tile.y1; ++y) {
+            for (int x = tile.x0; x < tile.x1; ++x) {
+                tileColors[(y - tile.y0) * tileWidth + (x - tile.x0)] = traceColor(scene, primaryRay(camera, x + 0.5, y + 0.5));
+            }
+        }
+    } else {
+        auto trace = [&](double px, double py) { return tracePrimary(scene, primaryRay(camera, px, py)); };
+        EdgeAdaptiveSampler sampler(settings.edgeSettings);
+        sampler.renderTile(tile, trace, tileColors.data(), tileWidth);
+    }
+}
+
+// Tile em RGBA8, usado pelos workers da renderização distribuída e pelo pool de threads
+inline void renderTileRGBA(const Scene& scene, const Camera& camera, const RenderSettings& settings, const Tile& tile,
+                           std::vector<unsigned char>& pixels) {
+    std::vector<Vec3> tileColors;
+    renderTileColors(scene, camera, settings, tile, tileColors);
+    resolveColors(tileColors, pixels);
+}
+
+#ifndef _WIN32
+inline void renderDistributed(const Scene& scene, const Camera& camera, const RenderSettings& settings,
+                              std::vector<unsigned char>& image) {
+    TileRenderFn renderTile = [&](const Tile& tile, std::vector<unsigned char>& pixels) {
+        renderTileRGBA(scene, camera, settings, tile, pixels);
+    };
+
+    std::vector<int> remoteFds;
+    for (const auto& address : settings.remoteWorkers) {
+        size_t colon = address.rfind(':');
+        int fd = colon == std::string::npos ? -1 : net::connectTcp(address.substr(0, colon), std::atoi(address.c_str() + colon + 1));
+        if (fd < 0) std::cout << "Não foi possível conectar ao worker " << address << std::endl;
+        else remoteFds.push_back(fd);
+    }
+
+    std::cout << "Iniciando renderização distribuída em " << settings.workerProcesses << " processos locais e "
+              << remoteFds.size() << " remotos..." << std::endl;
+    LocalWorkers workers(settings.workerProcesses, renderTile);
+    std::vector<int> fds = workers.fds;
+    fds.insert(fds.end(), remoteFds.begin(), remoteFds.end());
+    TileCoordinator coordinator;
+    coordinator.render(fds, camera.hres, camera.vres, renderTile, image);
+    for (int fd : coordinator.deadFds) workers.abandon(fd);
+    for (int fd : remoteFds) close(fd);
+    std::cout << "Renderização concluída (" << coordinator.reissuedTiles << " tiles reemitidos, "
+              << coordinator.deadWorkers << " workers perdidos)." << std::endl;
+}
+#endif
+
+// Cores da imagem inteira com o modo de amostragem escolhido e, se pedido, o denoiser (no pool, se houver)
+inline void renderColors(const Scene& scene, const Camera& camera, const RenderSettings& settings, std::vector<Vec3>& colors,
+                         ThreadPool* pool = nullptr) {
+    colors.assign(size_t(camera.hres) * camera.vres, Vec3());
+    if (settings.samplingMode == SamplingMode::PixelCenter) {
+        render(scene, camera, colors);
+        return;
+    }
+
+    if (settings.samplingMode == SamplingMode::EdgeAdaptive) {
+        std::cout << "Iniciando renderização com anti-aliasing adaptativo..." << std::endl;
+        auto trace = [&](double px, double py) { return tracePrimary(scene, primaryRay(camera, px, py)); };
+        EdgeAdaptiveSampler sampler(settings.edgeSettings);
+        sampler.render(camera.hres, camera.vres, trace, colors);
+        std::cout << "Renderização concluída: " << sampler.raysTraced << " raios ("
+                  << double(sampler.raysTraced) / (camera.hres * camera.vres) << " por pixel)." << std::endl;
+    } else {
+        std::cout << "Iniciando renderização adaptativa..." << std::endl;
+        AccumulationBuffer accum(camera.hres, camera.vres);
+        auto sample = [&](double px, double py, double lensU, double lensV, double time) {
+            return traceColor(scene, primaryRay(camera, px, py, lensU, lensV, time));
+        };
+        long long totalSamples = renderAdaptive(camera.hres, camera.vres, settings.adaptiveSettings, sample, accum, camera.thinLens());
+        colors = accum.mean;
+        std::cout << "Renderização concluída: " << totalSamples << " amostras ("
+                  << double(totalSamples) / (camera.hres * camera.vres) << " por pixel)." << std::endl;
+
+        if (!settings.heatmapPath.empty()) {
+            // Salva o mapa de calor das amostras gastas por pixel
+            std::vector<unsigned char> heatmap(size_t(camera.hres) * camera.vres * 4);
+            writeSampleHeatmap(accum, settings.adaptiveSettings.maxSamples, heatmap);
+            unsigned heatmapError = lodepng::encode(settings.heatmapPath, heatmap, camera.hres, camera.vres);
+            if (heatmapError) {
+                std::cout << "Encoder error " << heatmapError << ": " << lodepng_error_text(heatmapError) << std::endl;
+            }
+        }
+    }
+
+    if (settings.denoise) {
+        std::cout << "Aplicando denoiser à-trous..." << std::endl;
+        GBuffer gbuffer(camera.hres, camera.vres);
+        renderGBuffer(scene, camera, gbuffer);
+        AtrousDenoiser denoiser(settings.denoiseSettings);
+        denoiser.denoise(colors, gbuffer, pool);
+        std::cout << "Denoiser concluído em " << denoiser.lastMilliseconds << " ms ("
+                  << denoiser.lastMillisecondsPerMegapixel << " ms por megapixel)." << std::endl;
+    }
+}
+
+// Renderiza a imagem RGBA8 com o modo de amostragem escolhido e, se pedido, o denoiser
+inline void renderImage(const Scene& scene, const Camera& camera, const RenderSettings& settings, std::vector<unsigned char>& image,
+                        ThreadPool* pool = nullptr) {
+#ifndef _WIN32
+    if (settings.workerProcesses > 0 || !settings.remoteWorkers.empty()) {
+        renderDistributed(scene, camera, settings, image);
+        return;
+    }
+#endif
+    std::vector<Vec3> colors;
+    renderColors(scene, camera, settings, colors, pool);
+    resolveColors(colors, image);
+}
+
+// Tiles distribuídos entre as threads do pool. O modo VarianceAdaptive e o denoiser trabalham
+// sobre a imagem inteira e continuam em renderImage.
+inline void renderImageParallel(const Scene& scene, const Camera& camera, const RenderSettings& settings, ThreadPool& pool,
+                                std::vector<unsigned char>& image) {
+    if (settings.samplingMode == SamplingMode::VarianceAdaptive || settings.denoise) {
+        renderImage(scene, camera, settings, image, &pool);
+        return;
+    }
+    std::vector<Tile> tiles = makeTiles(camera.hres, camera.vres, 32);
+    pool.parallelFor(int(tiles.size()), [&](int i) {
+        const Tile& tile = tiles[i];
+        std::vector<unsigned char> pixels(size_t(tile.x1 - tile.x0) * (tile.y1 - tile.y0) * 4);
+        renderTileRGBA(scene, camera, settings, tile, pixels);
+        size_t rowBytes = size_t(tile.x1 - tile.x0) * 4;
+        for (int y = tile.y0; y < tile.y1; ++y) {
+            std::memcpy(&image[(size_t(y) * camera.hres + tile.x0) * 4], &pixels[(y - tile.y0) * rowBytes], rowBytes);
+        }
+    });
+}
+
+// Framebuffer HDR: RGB float por pixel, sem clamp, para PFM, PNG de 16 bits e tone mapping (hdr.h).
+// Os workers distribuídos só devolvem RGBA8, então aqui a renderização é sempre local.
+inline void renderImageHDR(const Scene& scene, const Camera& camera, const RenderSettings& settings, ThreadPool& pool,
+                           std::vector<float>& hdr) {
+    if (settings.workerProcesses > 0 || !settings.remoteWorkers.empty()) {
+        std::cout << "Saída HDR: os workers devolvem só RGBA8, renderizando localmente (--workers e --remote ignorados)."
+                  << std::endl;
+    }
+    hdr.resize(size_t(camera.hres) * camera.vres * 3);
+    if (settings.samplingMode == SamplingMode::VarianceAdaptive || settings.denoise) {
+        std::vector<Vec3> colors;
+        renderColors(scene, camera, settings, colors, &pool);
+        for (size_t i = 0; i < colors.size(); ++i) {
+            hdr[3 * i + 0] = float(colors[i].x);
+            hdr[3 * i + 1] = float(colors[i].y);
+            hdr[3 * i + 2] = float(colors[i].z);
+        }
+        return;
+    }
+    std::vector<Tile> tiles = makeTiles(camera.hres, camera.vres, 32);
+    pool.parallelFor(int(tiles.size()), [&](int i) {
+        const Tile& tile = tiles[i];
+        std::vector<Vec3> tileColors;
+        renderTileColors(scene, camera, settings, tile, tileColors);
+        int tileWidth = tile.x1 - tile.x0;
+        for (int y = tile.y0; y < tile.y1; ++y) {
+            float* row = &hdr[(size_t(y) * camera.hres + tile.x0) * 3];
+            const Vec3* colors = &tileColors[size_t(y - tile.y0) * tileWidth];
+            for (int x = 0; x < tileWidth; ++x) {
+                row[3 * x + 0] = float(colors[x].x);
+                row[3 * x + 1] = float(colors[x].y);
+                row[3 * x + 2] = float(colors[x].z);
+            }
+        }
+    });
+}
+
+#endif // RENDERER_H
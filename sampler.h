@@ -0,0 +1,260 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+enum class SamplerType {
+    Random,          // ruído branco por hash, apenas como referência
+    Stratified,      // grade com jitter, precisa conhecer samplesPerPixel
+    Sobol,           // Sobol com embaralhamento XOR (random digit scrambling) por pixel
+    OwenSobol,       // Sobol com embaralhamento de Owen por hash (Laine-Karras)
+    BlueNoise        // tile de ruído azul 64x64 com rotação de Cranley-Patterson por amostra
+};
+
+namespace sampling {
+
+inline uint32_t hash(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+inline uint32_t hashCombine(uint32_t seed, uint32_t value) {
+    return hash(seed ^ (value + 0x9e3779b9u + (seed << 6) + (seed >> 2)));
+}
+
+inline uint32_t reverseBits(uint32_t x) {
+    x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+    x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+    x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+    x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+    return (x >> 16) | (x << 16);
+}
+
+inline uint32_t laineKarrasPermutation(uint32_t x, uint32_t seed) {
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return x;
+}
+
+// Embaralhamento de Owen aninhado: cada bit é invertido em função apenas dos bits mais significativos
+inline uint32_t nestedUniformScramble(uint32_t x, uint32_t seed) {
+    return reverseBits(laineKarrasPermutation(reverseBits(x), seed));
+}
+
+inline double toUnit(uint32_t x) {
+    return x * (1.0 / 4294967296.0);
+}
+
+const int SOBOL_DIMENSIONS = 8;
+const int SOBOL_BITS = 32;
+
+// Matrizes geradoras de Sobol com os números de direção de Joe e Kuo (new-joe-kuo-6.21201)
+class SobolMatrices {
+public:
+    uint32_t v[SOBOL_DIMENSIONS][SOBOL_BITS];
+
+    SobolMatrices() {
+        static const unsigned degree[SOBOL_DIMENSIONS] = { 0, 1, 2, 3, 3, 4, 4, 5 };
+        static const unsigned coeffs[SOBOL_DIMENSIONS] = { 0, 0, 1, 1, 2, 1, 4, 2 };
+        static const unsigned initial[SOBOL_DIMENSIONS][5] = {
+            { 0 }, { 1 }, { 1, 3 }, { 1, 3, 1 }, { 1, 1, 1 }, { 1, 1, 3, 3 }, { 1, 3, 5, 13 }, { 1, 1, 5, 5, 17 }
+        };
+
+        for (int i = 0; i < SOBOL_BITS; ++i) v[0][i] = 1u << (31 - i);
+
+        for (int d = 1; d < SOBOL_DIMENSIONS; ++d) {
+            unsigned s = degree[d];
+            for (unsigned i = 0; i < s; ++i) v[d][i] = initial[d][i] << (31 - i);
+            for (unsigned i = s; i < SOBOL_BITS; ++i) {
+                v[d][i] = v[d][i - s] ^ (v[d][i - s] >> s);
+                for (unsigned k = 1; k < s; ++k) {
+                    if ((coeffs[d] >> (s - 1 - k)) & 1) v[d][i] ^= v[d][i - k];
+                }
+            }
+        }
+    }
+};
+
+inline const SobolMatrices& sobolMatrices() {
+    static const SobolMatrices matrices;
+    return matrices;
+}
+
+inline uint32_t sobol(uint32_t index, uint32_t dimension) {
+    const uint32_t* v = sobolMatrices().v[dimension % SOBOL_DIMENSIONS];
+    uint32_t x = 0;
+    for (int bit = 0; index; index >>= 1, ++bit) {
+        if (index & 1) x ^= v[bit];
+    }
+    return x;
+}
+
+const int BLUE_NOISE_SIZE = 64;
+
+// Tile de ruído azul gerado uma única vez por void-and-cluster (Ulichney) com semente fixa.
+// ranks[y * 64 + x] é a ordem de inserção do pixel, de 0 a 4095.
+class BlueNoiseTile {
+public:
+    std::vector<uint16_t> ranks;
+
+    BlueNoiseTile() : ranks(BLUE_NOISE_SIZE * BLUE_NOISE_SIZE) {
+        const int n = BLUE_NOISE_SIZE * BLUE_NOISE_SIZE;
+        const int radius = 6;
+        const double sigma = 1.9;
+        std::vector<double> kernel((2 * radius + 1) * (2 * radius + 1));
+        for (int dy = -radius; dy <= radius; ++dy) {
+            for (int dx = -radius; dx <= radius; ++dx) {
+                kernel[(dy + radius) * (2 * radius + 1) + dx + radius] = std::exp(-(dx * dx + dy * dy) / (2 * sigma * sigma));
+            }
+        }
+
+        std::vector<char> pattern(n, 0);
+        std::vector<double> energy(n, 0.0);
+        auto splat = [&](int p, double sign) {
+            int px = p % BLUE_NOISE_SIZE, py = p / BLUE_NOISE_SIZE;
+            for (int dy = -radius; dy <= radius; ++dy) {
+                int y = (py + dy) & (BLUE_NOISE_SIZE - 1);
+                for (int dx = -radius; dx <= radius; ++dx) {
+                    int x = (px + dx) & (BLUE_NOISE_SIZE - 1);
+                    energy[y * BLUE_NOISE_SIZE + x] += sign * kernel[(dy + radius) * (2 * radius + 1) + dx + radius];
+                }
+            }
+        };
+        auto tightestCluster = [&]() {
+            int best = -1;
+            for (int p = 0; p < n; ++p) if (pattern[p] && (best < 0 || energy[p] > energy[best])) best = p;
+            return best;
+        };
+        auto largestVoid = [&]() {
+            int best = -1;
+            for (int p = 0; p < n; ++p) if (!pattern[p] && (best < 0 || energy[p] < energy[best])) best = p;
+            return best;
+        };
+
+        // Padrão inicial: 10% dos pixels escolhidos por hash, depois relaxado até estabilizar
+        int initialCount = 0;
+        for (int p = 0; p < n; ++p) {
+            if (hash(uint32_t(p) * 2654435761u + 17u) % 10 == 0) {
+                pattern[p] = 1;
+                splat(p, 1.0);
+                ++initialCount;
+            }
+        }
+        for (int iteration = 0; iteration < n; ++iteration) {
+            int cluster = tightestCluster();
+            pattern[cluster] = 0;
+            splat(cluster, -1.0);
+            int hole = largestVoid();
+            pattern[hole] = 1;
+            splat(hole, 1.0);
+            if (hole == cluster) break;
+        }
+        std::vector<char> initialPattern = pattern;
+        std::vector<double> initialEnergy = energy;
+
+        for (int rank = initialCount - 1; rank >= 0; --rank) {
+            int cluster = tightestCluster();
+            pattern[cluster] = 0;
+            splat(cluster, -1.0);
+            ranks[cluster] = uint16_t(rank);
+        }
+
+        pattern = initialPattern;
+        energy = initialEnergy;
+        for (int rank = initialCount; rank < n; ++rank) {
+            int hole = largestVoid();
+            pattern[hole] = 1;
+            splat(hole, 1.0);
+            ranks[hole] = uint16_t(rank);
+        }
+    }
+
+    double value(int x, int y) const {
+        int rank = ranks[(y & (BLUE_NOISE_SIZE - 1)) * BLUE_NOISE_SIZE + (x & (BLUE_NOISE_SIZE - 1))];
+        return (rank + 0.5) / (BLUE_NOISE_SIZE * BLUE_NOISE_SIZE);
+    }
+};
+
+inline const BlueNoiseTile& blueNoiseTile() {
+    static const BlueNoiseTile tile;
+    return tile;
+}
+
+} // namespace sampling
+
+// Amostrador determinístico: cada valor é função pura de (pixel, índice da amostra, dimensão),
+// logo a imagem não depende do número de threads nem da ordem em que os pixels são visitados.
+class Sampler {
+public:
+    SamplerType type;
+    int samplesPerPixel;
+    uint32_t seed;
+
+    Sampler(SamplerType t = SamplerType::OwenSobol, int spp = 16, uint32_t s = 0)
+        : type(t), samplesPerPixel(std::max(spp, 1)), seed(s) {
+        if (type == SamplerType::Sobol || type == SamplerType::OwenSobol) sampling::sobolMatrices();
+        if (type == SamplerType::BlueNoise) sampling::blueNoiseTile();
+    }
+
+    double get1D(int x, int y, uint32_t sampleIndex, uint32_t dimension) const {
+        uint32_t pixelSeed = pixelHash(x, y);
+        switch (type) {
+        case SamplerType::Stratified: {
+            uint32_t strata = uint32_t(samplesPerPixel);
+            uint32_t stratum = (sampleIndex + sampling::hashCombine(pixelSeed, dimension)) % strata;
+            return (stratum + jitter(pixelSeed, sampleIndex, dimension)) / strata;
+        }
+        case SamplerType::Sobol:
+            return sampling::toUnit(sampling::sobol(sampleIndex, dimension) ^ sampling::hashCombine(pixelSeed, dimension));
+        case SamplerType::OwenSobol: {
+            uint32_t index = sampling::nestedUniformScramble(sampleIndex, pixelSeed);
+            uint32_t dimSeed = sampling::hashCombine(pixelSeed, dimension + 1);
+            return sampling::toUnit(sampling::nestedUniformScramble(sampling::sobol(index, dimension), dimSeed));
+        }
+        case SamplerType::BlueNoise: {
+            uint32_t offset = sampling::hash(seed ^ (dimension * 0x68bc21ebu));
+            double base = sampling::blueNoiseTile().value(x + int(offset & 63), y + int((offset >> 6) & 63));
+            double rotated = base + sampleIndex * 0.6180339887498949 + dimension * 0.7548776662466927;
+            return rotated - std::floor(rotated);
+        }
+        case SamplerType::Random:
+        default:
+            return jitter(pixelSeed, sampleIndex, dimension);
+        }
+    }
+
+    // Par de dimensões (dimension, dimension + 1), estratificado em 2D quando o tipo permite
+    void get2D(int x, int y, uint32_t sampleIndex, uint32_t dimension, double& u, double& v) const {
+        if (type == SamplerType::Stratified) {
+            uint32_t pixelSeed = pixelHash(x, y);
+            uint32_t side = uint32_t(std::ceil(std::sqrt(double(samplesPerPixel))));
+            uint32_t cell = (sampleIndex + sampling::hashCombine(pixelSeed, dimension)) % (side * side);
+            u = (cell % side + jitter(pixelSeed, sampleIndex, dimension)) / side;
+            v = (cell / side + jitter(pixelSeed, sampleIndex, dimension + 1)) / side;
+            return;
+        }
+        u = get1D(x, y, sampleIndex, dimension);
+        v = get1D(x, y, sampleIndex, dimension + 1);
+    }
+
+private:
+    uint32_t pixelHash(int x, int y) const {
+        return sampling::hashCombine(sampling::hash(uint32_t(x) * 73856093u ^ uint32_t(y) * 19349663u), seed);
+    }
+
+    double jitter(uint32_t pixelSeed, uint32_t sampleIndex, uint32_t dimension) const {
+        return sampling::toUnit(sampling::hashCombine(sampling::hashCombine(pixelSeed, sampleIndex), dimension));
+    }
+};
+
+#endif // SAMPLER_H
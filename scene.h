@@ -0,0 +1,389 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include "point3.h"
+#include "vec3.h"
+#include "camera.h"
+#include "sphere.h"
+#include "plane.h"
+#include "array_view.h"
+#include "bvh.h"
+
+class Light {
+public:
+    Point3 position;
+    Vec3 color;
+
+    Light(Point3 p, Vec3 c) : position(p), color(c) {}
+};
+
+class Material {
+public:
+    std::string name;
+    Vec3 color;
+
+    Material(const std::string& n, Vec3 c) : name(n), color(c) {}
+};
+
+// Malhas ainda não são renderizadas (mesh.h está vazio): a cena apenas guarda a referência
+class MeshReference {
+public:
+    std::string path;
+    Vec3 color;
+
+    MeshReference(const std::string& p, Vec3 c) : path(p), color(c) {}
+};
+
+class Scene {
+public:
+    Camera camera;
+    Vec3 background;
+    Vec3 ambient;
+    std::vector<Sphere> spheres;
+    std::vector<Plane> planes;
+    std::vector<Light> lights;
+    std::vector<Material> materials;
+    std::vector<MeshReference> meshes;
+
+    // Cena carregada do cache binário (scene_cache.h): os arrays apontam direto para o arquivo
+    // mapeado, mantido vivo por mapping, e os vetores acima ficam vazios
+    std::shared_ptr<const void> mapping;
+    ArrayView<Sphere> mappedSpheres;
+    ArrayView<Plane> mappedPlanes;
+    ArrayView<Light> mappedLights;
+
+    // Hierarquia sobre as esferas; nula em cenas pequenas, onde o teste linear é mais rápido
+    std::shared_ptr<const BVH> bvh;
+
+    Scene()
+        : camera(Point3(0, 0, 0), Point3(0, 0, -1), Vec3(0, 1, 0), 1.0, 500, 500),
+          background(0, 0, 0), ambient(0.1, 0.1, 0.1) {}
+
+    ArrayView<Sphere> sphereView() const { return mapping ? mappedSpheres : ArrayView<Sphere>(spheres); }
+    ArrayView<Plane> planeView() const { return mapping ? mappedPlanes : ArrayView<Plane>(planes); }
+    ArrayView<Light> lightView() const { return mapping ? mappedLights : ArrayView<Light>(lights); }
+};
+
+// A cena que antes ficava fixa em main()
+inline Scene defaultScene() {
+    Scene scene;
+    scene.spheres = {
+        Sphere(Point3(-1.5, -0.5, -2.5), 0.6, Vec3(0, 0, 0)),
+        Sphere(Point3(0.8, -0.9, -3), 0.8, Vec3(0, 1, 0)),
+        Sphere(Point3(0.5, -0.5, -1.5), 0.28, Vec3(1, 1, 0)),
+        Sphere(Point3(1.5, 2, -3), 0.58, Vec3(0, 1, 1)),
+        Sphere(Point3(2.5, 1, -5), 0.48, Vec3(1, 0, 0))
+    };
+    scene.planes = {
+        Plane(Point3(0, -1, 0), Vec3(0, 1, 0), Vec3(1, 0, 1))
+    };
+    return scene;
+}
+
+// Formato texto, uma diretiva por linha, '#' inicia comentário:
+//   camera px py pz  lx ly lz  ux uy uz  distância
+//   resolution largura altura
+//   lens raio-da-abertura distância-de-foco
+//   background r g b
+//   ambient r g b
+//   material nome r g b
+//   light px py pz  r g b
+//   sphere cx cy cz raio  (nome-do-material | r g b)  [motion ex ey ez]
+//   plane px py pz  nx ny nz  (nome-do-material | r g b)
+//   mesh "arquivo.obj"  (nome-do-material | r g b)
+// Leitura em uma única passada sobre o arquivo carregado inteiro na memória, sem iostreams.
+class SceneParser {
+public:
+    std::string error;
+
+    bool parse(const char* data, size_t size, Scene& scene) {
+        p = data;
+        end = data + size;
+        line = 1;
+        reserve(data, size, scene);
+
+        while (p < end) {
+            skipBlank();
+            if (p >= end) break;
+            if (*p == '\n') {
+                ++p;
+                ++line;
+                continue;
+            }
+            if (*p == '#') {
+                skipLine();
+                continue;
+            }
+            const char* keyword = p;
+            skipWord();
+            size_t length = size_t(p - keyword);
+            bool ok;
+            if (is(keyword, length, "sphere")) ok = parseSphere(scene);
+            else if (is(keyword, length, "plane")) ok = parsePlane(scene);
+            else if (is(keyword, length, "camera")) ok = parseCamera(scene);
+            else if (is(keyword, length, "resolution")) ok = parseResolution(scene);
+            else if (is(keyword, length, "lens")) ok = parseLens(scene);
+            else if (is(keyword, length, "background")) ok = readVec3(scene.background);
+            else if (is(keyword, length, "ambient")) ok = readVec3(scene.ambient);
+            else if (is(keyword, length, "material")) ok = parseMaterial(scene);
+            else if (is(keyword, length, "light")) ok = parseLight(scene);
+            else if (is(keyword, length, "mesh")) ok = parseMesh(scene);
+            else ok = fail("diretiva desconhecida '" + std::string(keyword, length) + "'");
+            if (!ok) return false;
+            if (!endOfLine()) return fail("conteúdo inesperado no fim da linha");
+        }
+        return true;
+    }
+
+private:
+    const char* p = nullptr;
+    const char* end = nullptr;
+    int line = 1;
+    std::unordered_map<std::string, int> materialIndex;
+
+    bool fail(const std::string& message) {
+        error = "linha " + std::to_string(line) + ": " + message;
+        return false;
+    }
+
+    // Contagem rápida pelas iniciais das linhas para reservar os vetores antes da leitura
+    static void reserve(const char* data, size_t size, Scene& scene) {
+        size_t sphereLines = 0, planeLines = 0;
+        const char* q = data;
+        const char* last = data + size;
+        while (q < last) {
+            while (q < last && (*q == ' ' || *q == '\t')) ++q;
+            if (q < last) {
+                if (*q == 's') ++sphereLines;
+                else if (*q == 'p') ++planeLines;
+            }
+            const void* nl = std::memchr(q, '\n', size_t(last - q));
+            if (!nl) break;
+            q = static_cast<const char*>(nl) + 1;
+        }
+        scene.spheres.reserve(scene.spheres.size() + sphereLines);
+        scene.planes.reserve(scene.planes.size() + planeLines);
+    }
+
+    void skipBlank() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+    }
+
+    void skipLine() {
+        while (p < end && *p != '\n') ++p;
+    }
+
+    bool endOfLine() {
+        skipBlank();
+        if (p < end && *p == '#') skipLine();
+        return p >= end || *p == '\n';
+    }
+
+    void skipWord() {
+        while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n' && *p != '#') ++p;
+    }
+
+    static bool is(const char* word, size_t length, const char* keyword) {
+        return std::strlen(keyword) == length && std::memcmp(word, keyword, length) == 0;
+    }
+
+    std::string readWord() {
+        skipBlank();
+        const char* start = p;
+        skipWord();
+        return std::string(start, p);
+    }
+
+    static bool isDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    // Decimal simples: [-+]dígitos[.dígitos][e[-+]dígitos]
+    bool readNumber(double& out) {
+        static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                         1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+        skipBlank();
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+        uint64_t mantissa = 0;
+        int exponent = 0, digits = 0;
+        for (; p < end && isDigit(*p); ++p, ++digits) {
+            if (mantissa < 100000000000000000ull) mantissa = mantissa * 10 + uint64_t(*p - '0');
+            else ++exponent;
+        }
+        if (p < end && *p == '.') {
+            for (++p; p < end && isDigit(*p); ++p, ++digits) {
+                if (mantissa < 100000000000000000ull) {
+                    mantissa = mantissa * 10 + uint64_t(*p - '0');
+                    --exponent;
+                }
+            }
+        }
+        if (digits == 0) return fail("número esperado");
+        if (p < end && (*p == 'e' || *p == 'E')) {
+            ++p;
+            bool negativeExp = false;
+            if (p < end && (*p == '-' || *p == '+')) negativeExp = *p++ == '-';
+            int e = 0;
+            if (p >= end || !isDigit(*p)) return fail("expoente inválido");
+            for (; p < end && isDigit(*p); ++p) e = std::min(e * 10 + (*p - '0'), 10000);
+            exponent += negativeExp ? -e : e;
+        }
+        double value = double(mantissa);
+        if (exponent < 0) value = -exponent <= 22 ? value / powers[-exponent] : value * std::pow(10.0, exponent);
+        else if (exponent > 0) value = exponent <= 22 ? value * powers[exponent] : value * std::pow(10.0, exponent);
+        out = negative ? -value : value;
+        if (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n' && *p != '#') return fail("número inválido");
+        return true;
+    }
+
+    bool readVec3(Vec3& v) {
+        return readNumber(v.x) && readNumber(v.y) && readNumber(v.z);
+    }
+
+    bool readPoint3(Point3& pt) {
+        return readNumber(pt.x) && readNumber(pt.y) && readNumber(pt.z);
+    }
+
+    // Cor literal (r g b) ou nome de material declarado antes
+    bool readMaterialColor(Scene& scene, Vec3& color) {
+        skipBlank();
+        if (p < end && (isDigit(*p) || *p == '-' || *p == '+' || *p == '.')) return readVec3(color);
+        std::string name = readWord();
+        if (name.empty()) return fail("cor ou material esperado");
+        auto it = materialIndex.find(name);
+        if (it == materialIndex.end()) return fail("material não declarado '" + name + "'");
+        color = scene.materials[it->second].color;
+        return true;
+    }
+
+    bool parseSphere(Scene& scene) {
+        Point3 center;
+        double radius;
+        Vec3 color;
+        if (!readPoint3(center) || !readNumber(radius) || !readMaterialColor(scene, color)) return false;
+        if (radius <= 0) return fail("raio deve ser positivo");
+        // Centro final opcional para desfoque de movimento
+        Vec3 motion(0, 0, 0);
+        if (!endOfLine()) {
+            Point3 endCenter;
+            if (readWord() != "motion") return fail("esperado 'motion' após a cor da esfera");
+            if (!readPoint3(endCenter)) return false;
+            motion = Vec3(endCenter.x - center.x, endCenter.y - center.y, endCenter.z - center.z);
+        }
+        scene.spheres.push_back(Sphere(center, radius, color, motion));
+        return true;
+    }
+
+    bool parsePlane(Scene& scene) {
+        Point3 point;
+        Vec3 normal, color;
+        if (!readPoint3(point) || !readVec3(normal) || !readMaterialColor(scene, color)) return false;
+        if (normal.length() == 0) return fail("normal nula");
+        scene.planes.push_back(Plane(point, normal.normalize(), color));
+        return true;
+    }
+
+    bool parseCamera(Scene& scene) {
+        Point3 position, lookAt;
+        Vec3 up;
+        double distance;
+        if (!readPoint3(position) || !readPoint3(lookAt) || !readVec3(up) || !readNumber(distance)) return false;
+        // Campo a campo: resolução e lente podem ter sido declaradas antes
+        scene.camera.position = position;
+        scene.camera.lookAt = lookAt;
+        scene.camera.up = up;
+        scene.camera.distance = distance;
+        return true;
+    }
+
+    bool parseLens(Scene& scene) {
+        double aperture, focusDistance;
+        if (!readNumber(aperture) || !readNumber(focusDistance)) return false;
+        if (aperture < 0 || focusDistance <= 0) return fail("abertura negativa ou distância de foco não positiva");
+        scene.camera.aperture = aperture;
+        scene.camera.focusDistance = focusDistance;
+        return true;
+    }
+
+    bool parseResolution(Scene& scene) {
+        double width, height;
+        if (!readNumber(width) || !readNumber(height)) return false;
+        if (width < 1 || height < 1) return fail("resolução inválida");
+        scene.camera.hres = int(width);
+        scene.camera.vres = int(height);
+        return true;
+    }
+
+    bool parseMaterial(Scene& scene) {
+        std::string name = readWord();
+        Vec3 color;
+        if (name.empty()) return fail("nome do material esperado");
+        if (!readVec3(color)) return false;
+        materialIndex[name] = int(scene.materials.size());
+        scene.materials.push_back(Material(name, color));
+        return true;
+    }
+
+    bool parseLight(Scene& scene) {
+        Point3 position;
+        Vec3 color;
+        if (!readPoint3(position) || !readVec3(color)) return false;
+        scene.lights.push_back(Light(position, color));
+        return true;
+    }
+
+    bool parseMesh(Scene& scene) {
+        skipBlank();
+        std::string path;
+        if (p < end && *p == '"') {
+            const char* start = ++p;
+            while (p < end && *p != '"' && *p != '\n') ++p;
+            if (p >= end || *p != '"') return fail("aspas não fechadas");
+            path.assign(start, p++);
+        } else {
+            path = readWord();
+        }
+        if (path.empty()) return fail("caminho da malha esperado");
+        Vec3 color(1, 1, 1);
+        if (!endOfLine() && !readMaterialColor(scene, color)) return false;
+        scene.meshes.push_back(MeshReference(path, color));
+        return true;
+    }
+};
+
+inline bool loadScene(const std::string& path, Scene& scene, std::string& error) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        error = "não foi possível abrir " + path;
+        return false;
+    }
+    std::fseek(file, 0, SEEK_END);
+    long size = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+    std::vector<char> data(size > 0 ? size_t(size) : 0);
+    size_t read = data.empty() ? 0 : std::fread(data.data(), 1, data.size(), file);
+    std::fclose(file);
+    if (read != data.size()) {
+        error = "erro ao ler " + path;
+        return false;
+    }
+
+    SceneParser parser;
+    if (!parser.parse(data.data(), data.size(), scene)) {
+        error = path + ": " + parser.error;
+        return false;
+    }
+    return true;
+}
+
+#endif // SCENE_H
@@ -0,0 +1,416 @@
+#ifndef SCENE_CACHE_H
+#define SCENE_CACHE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <type_traits>
+#include "scene.h"
+#include "lodepng.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#else
+#include <process.h>
+#endif
+
+// Cache binário de cena: cabeçalho, tabela de seções e seções alinhadas a 64 bytes. Esferas,
+// planos e luzes são gravados com o layout em memória das próprias classes, então o arquivo
+// mapeado é usado no lugar, sem leitura nem cópia. Qualquer mudança nesses layouts deve
+// incrementar SCENE_CACHE_VERSION; os tamanhos gravados no cabeçalho também são conferidos.
+
+static_assert(std::is_trivially_copyable<Sphere>::value && std::is_standard_layout<Sphere>::value, "Sphere precisa ser POD");
+static_assert(std::is_trivially_copyable<Plane>::value && std::is_standard_layout<Plane>::value, "Plane precisa ser POD");
+static_assert(std::is_trivially_copyable<Light>::value && std::is_standard_layout<Light>::value, "Light precisa ser POD");
+
+namespace scenecache {
+
+const char MAGIC[8] = { 'P', 'G', 'S', 'C', 'E', 'N', 'E', 0 };
+const uint32_t SCENE_CACHE_VERSION = 3;
+const uint32_t ENDIAN_TAG = 0x01020304;
+const size_t SECTION_ALIGNMENT = 64;
+
+enum SectionType : uint32_t {
+    SECTION_SETTINGS = 1,
+    SECTION_SPHERES = 2,
+    SECTION_PLANES = 3,
+    SECTION_LIGHTS = 4,
+    SECTION_MATERIALS = 5,
+    SECTION_MESHES = 6,
+    SECTION_STRINGS = 7
+};
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t endianTag;
+    uint32_t sectionCount;
+    uint32_t sphereSize, planeSize, lightSize;
+    uint64_t fileSize;
+    uint32_t tableChecksum;
+    uint32_t headerChecksum;  // calculado com este campo zerado
+};
+
+struct Section {
+    uint32_t type;
+    uint32_t elementSize;
+    uint64_t offset;
+    uint64_t count;
+    uint32_t checksum;
+    uint32_t reserved;
+};
+
+struct SettingsRecord {
+    double position[3], lookAt[3], up[3];
+    double distance;
+    int32_t hres, vres;
+    double background[3];
+    double ambient[3];
+    double aperture, focusDistance;
+};
+
+struct MaterialRecord {
+    char name[40];
+    double color[3];
+};
+
+struct MeshRecord {
+    double color[3];
+    uint32_t pathOffset, pathLength;  // na seção de strings
+};
+
+inline uint32_t checksum(const void* data, size_t size) {
+    return size ? lodepng_crc32(static_cast<const unsigned char*>(data), size) : 0;
+}
+
+// Arquivo inteiro em memória: mmap somente leitura no POSIX, leitura para o heap nos demais
+class MappedFile {
+public:
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+
+    bool open(const std::string& path) {
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+        void* p = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return false;
+        mapped = true;
+        data = static_cast<const unsigned char*>(p);
+        size = size_t(st.st_size);
+        return true;
+#else
+        FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file) return false;
+        std::fseek(file, 0, SEEK_END);
+        long length = std::ftell(file);
+        std::fseek(file, 0, SEEK_SET);
+        // uint64_t garante alinhamento de 8 bytes para os doubles das seções
+        buffer.resize((size_t(std::max(length, 0L)) + 7) / 8);
+        size = length > 0 ? std::fread(buffer.data(), 1, size_t(length), file) : 0;
+        std::fclose(file);
+        data = reinterpret_cast<const unsigned char*>(buffer.data());
+        return length > 0 && size == size_t(length);
+#endif
+    }
+
+    ~MappedFile() {
+#ifndef _WIN32
+        if (mapped) munmap(const_cast<unsigned char*>(data), size);
+#endif
+    }
+
+private:
+#ifndef _WIN32
+    bool mapped = false;
+#else
+    std::vector<uint64_t> buffer;
+#endif
+};
+
+class Writer {
+public:
+    std::vector<Section> sections;
+    std::vector<unsigned char> body;  // seções, a partir do offset bodyStart
+
+    void add(uint32_t type, const void* data, size_t elementSize, size_t count) {
+        while (body.size() % SECTION_ALIGNMENT) body.push_back(0);
+        Section section;
+        section.type = type;
+        section.elementSize = uint32_t(elementSize);
+        section.offset = body.size();
+        section.count = count;
+        section.checksum = checksum(data, elementSize * count);
+        section.reserved = 0;
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        body.insert(body.end(), bytes, bytes + elementSize * count);
+        sections.push_back(section);
+    }
+};
+
+inline void fill3(double out[3], double x, double y, double z) {
+    out[0] = x;
+    out[1] = y;
+    out[2] = z;
+}
+
+} // namespace scenecache
+
+inline bool isSceneCacheFile(const std::string& path) {
+    char magic[8] = { 0 };
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+    size_t read = std::fread(magic, 1, sizeof(magic), file);
+    std::fclose(file);
+    return read == sizeof(magic) && std::memcmp(magic, scenecache::MAGIC, sizeof(magic)) == 0;
+}
+
+// Converte qualquer cena já carregada (texto ou embutida) para o cache binário
+inline bool writeSceneCache(const Scene& scene, const std::string& path, std::string& error) {
+    using namespace scenecache;
+    Writer writer;
+
+    SettingsRecord settings;
+    std::memset(&settings, 0, sizeof(settings));
+    const Camera& c = scene.camera;
+    fill3(settings.position, c.position.x, c.position.y, c.position.z);
+    fill3(settings.lookAt, c.lookAt.x, c.lookAt.y, c.lookAt.z);
+    fill3(settings.up, c.up.x, c.up.y, c.up.z);
+    settings.distance = c.distance;
+    settings.hres = c.hres;
+    settings.vres = c.vres;
+    settings.aperture = c.aperture;
+    settings.focusDistance = c.focusDistance;
+    fill3(settings.background, scene.background.x, scene.background.y, scene.background.z);
+    fill3(settings.ambient, scene.ambient.x, scene.ambient.y, scene.ambient.z);
+    writer.add(SECTION_SETTINGS, &settings, sizeof(settings), 1);
+
+    ArrayView<Sphere> spheres = scene.sphereView();
+    ArrayView<Plane> planes = scene.planeView();
+    ArrayView<Light> lights = scene.lightView();
+    writer.add(SECTION_SPHERES, spheres.data(), sizeof(Sphere), spheres.size());
+    writer.add(SECTION_PLANES, planes.data(), sizeof(Plane), planes.size());
+    writer.add(SECTION_LIGHTS, lights.data(), sizeof(Light), lights.size());
+
+    std::vector<MaterialRecord> materials(scene.materials.size());
+    for (size_t i = 0; i < materials.size(); ++i) {
+        std::memset(&materials[i], 0, sizeof(MaterialRecord));
+        std::strncpy(materials[i].name, scene.materials[i].name.c_str(), sizeof(materials[i].name) - 1);
+        const Vec3& color = scene.materials[i].color;
+        fill3(materials[i].color, color.x, color.y, color.z);
+    }
+    writer.add(SECTION_MATERIALS, materials.data(), sizeof(MaterialRecord), materials.size());
+
+    std::vector<MeshRecord> meshes(scene.meshes.size());
+    std::string strings;
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        const MeshReference& mesh = scene.meshes[i];
+        fill3(meshes[i].color, mesh.color.x, mesh.color.y, mesh.color.z);
+        meshes[i].pathOffset = uint32_t(strings.size());
+        meshes[i].pathLength = uint32_t(mesh.path.size());
+        strings += mesh.path;
+    }
+    writer.add(SECTION_MESHES, meshes.data(), sizeof(MeshRecord), meshes.size());
+    writer.add(SECTION_STRINGS, strings.data(), 1, strings.size());
+
+    size_t tableSize = writer.sections.size() * sizeof(Section);
+    size_t bodyStart = (sizeof(Header) + tableSize + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+    for (auto& section : writer.sections) section.offset += bodyStart;
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = SCENE_CACHE_VERSION;
+    header.endianTag = ENDIAN_TAG;
+    header.sectionCount = uint32_t(writer.sections.size());
+    header.sphereSize = sizeof(Sphere);
+    header.planeSize = sizeof(Plane);
+    header.lightSize = sizeof(Light);
+    header.fileSize = bodyStart + writer.body.size();
+    header.tableChecksum = checksum(writer.sections.data(), tableSize);
+    header.headerChecksum = checksum(&header, sizeof(header));
+
+    std::vector<unsigned char> padding(bodyStart - sizeof(Header) - tableSize, 0);
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        error = "não foi possível criar " + path;
+        return false;
+    }
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              std::fwrite(writer.sections.data(), 1, tableSize, file) == tableSize &&
+              std::fwrite(padding.data(), 1, padding.size(), file) == padding.size() &&
+              std::fwrite(writer.body.data(), 1, writer.body.size(), file) == writer.body.size();
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) error = "erro ao gravar " + path;
+    return ok;
+}
+
+// Mapeia o cache e aponta as views da cena para dentro dele. verifyData confere o CRC de cada
+// seção (uma passada de leitura sobre o arquivo); cabeçalho e tabela são sempre conferidos.
+inline bool loadSceneCache(const std::string& path, Scene& scene, std::string& error, bool verifyData = true) {
+    using namespace scenecache;
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+    if (!file->open(path)) {
+        error = "não foi possível mapear " + path;
+        return false;
+    }
+    if (file->size < sizeof(Header)) {
+        error = path + ": arquivo truncado";
+        return false;
+    }
+
+    Header header;
+    std::memcpy(&header, file->data, sizeof(header));
+    uint32_t storedHeaderChecksum = header.headerChecksum;
+    header.headerChecksum = 0;
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        error = path + ": não é um cache de cena";
+        return false;
+    }
+    if (checksum(&header, sizeof(header)) != storedHeaderChecksum) {
+        error = path + ": cabeçalho corrompido";
+        return false;
+    }
+    if (header.version != SCENE_CACHE_VERSION || header.endianTag != ENDIAN_TAG || header.sphereSize != sizeof(Sphere) ||
+        header.planeSize != sizeof(Plane) || header.lightSize != sizeof(Light)) {
+        error = path + ": cache gerado por outra versão do renderizador, converta a cena novamente";
+        return false;
+    }
+    size_t tableSize = size_t(header.sectionCount) * sizeof(Section);
+    if (header.fileSize != file->size || sizeof(Header) + tableSize > file->size) {
+        error = path + ": tamanho inconsistente";
+        return false;
+    }
+    const Section* sections = reinterpret_cast<const Section*>(file->data + sizeof(Header));
+    if (checksum(sections, tableSize) != header.tableChecksum) {
+        error = path + ": tabela de seções corrompida";
+        return false;
+    }
+
+    const size_t elementSizes[8] = { 0, sizeof(SettingsRecord), sizeof(Sphere), sizeof(Plane), sizeof(Light),
+                                     sizeof(MaterialRecord), sizeof(MeshRecord), 1 };
+    const void* found[8] = { nullptr };
+    size_t counts[8] = { 0 };
+    for (uint32_t i = 0; i < header.sectionCount; ++i) {
+        const Section& s = sections[i];
+        if (s.type == 0 || s.type >= 8) continue;  // seções desconhecidas são ignoradas
+        if (s.elementSize != elementSizes[s.type]) {
+            error = path + ": tamanho de elemento inesperado na seção " + std::to_string(s.type);
+            return false;
+        }
+        if (s.offset % SECTION_ALIGNMENT != 0 || s.offset > file->size || s.count > (file->size - s.offset) / s.elementSize) {
+            error = path + ": seção fora do arquivo";
+            return false;
+        }
+        if (verifyData && checksum(file->data + s.offset, size_t(s.count * s.elementSize)) != s.checksum) {
+            error = path + ": seção " + std::to_string(s.type) + " corrompida";
+            return false;
+        }
+        found[s.type] = file->data + s.offset;
+        counts[s.type] = size_t(s.count);
+    }
+    if (!found[SECTION_SETTINGS] || counts[SECTION_SETTINGS] != 1) {
+        error = path + ": seção de configurações ausente";
+        return false;
+    }
+
+    const SettingsRecord& settings = *static_cast<const SettingsRecord*>(found[SECTION_SETTINGS]);
+    if (settings.hres < 1 || settings.vres < 1 || settings.hres > MAX_IMAGE_DIMENSION || settings.vres > MAX_IMAGE_DIMENSION) {
+        error = path + ": resolução inválida";
+        return false;
+    }
+    scene = Scene();
+    scene.camera = Camera(Point3(settings.position[0], settings.position[1], settings.position[2]),
+                          Point3(settings.lookAt[0], settings.lookAt[1], settings.lookAt[2]),
+                          Vec3(settings.up[0], settings.up[1], settings.up[2]), settings.distance, settings.vres, settings.hres);
+    scene.camera.aperture = settings.aperture;
+    scene.camera.focusDistance = settings.focusDistance;
+    scene.background = Vec3(settings.background[0], settings.background[1], settings.background[2]);
+    scene.ambient = Vec3(settings.ambient[0], settings.ambient[1], settings.ambient[2]);
+
+    scene.mappedSpheres = ArrayView<Sphere>(static_cast<const Sphere*>(found[SECTION_SPHERES]), counts[SECTION_SPHERES]);
+    scene.mappedPlanes = ArrayView<Plane>(static_cast<const Plane*>(found[SECTION_PLANES]), counts[SECTION_PLANES]);
+    scene.mappedLights = ArrayView<Light>(static_cast<const Light*>(found[SECTION_LIGHTS]), counts[SECTION_LIGHTS]);
+
+    // Materiais e malhas são poucos e têm strings: estes sim são copiados
+    const MaterialRecord* materials = static_cast<const MaterialRecord*>(found[SECTION_MATERIALS]);
+    for (size_t i = 0; i < counts[SECTION_MATERIALS]; ++i) {
+        std::string name(materials[i].name, strnlen(materials[i].name, sizeof(materials[i].name)));
+        scene.materials.push_back(Material(name, Vec3(materials[i].color[0], materials[i].color[1], materials[i].color[2])));
+    }
+    const MeshRecord* meshes = static_cast<const MeshRecord*>(found[SECTION_MESHES]);
+    const char* strings = static_cast<const char*>(found[SECTION_STRINGS]);
+    for (size_t i = 0; i < counts[SECTION_MESHES]; ++i) {
+        if (!strings || size_t(meshes[i].pathOffset) + meshes[i].pathLength > counts[SECTION_STRINGS]) {
+            error = path + ": caminho de malha inválido";
+            return false;
+        }
+        scene.meshes.push_back(MeshReference(std::string(strings + meshes[i].pathOffset, meshes[i].pathLength),
+                                             Vec3(meshes[i].color[0], meshes[i].color[1], meshes[i].color[2])));
+    }
+
+    scene.mapping = file;
+    return true;
+}
+
+// Esferas a partir das quais a BVH compensa em relação ao teste linear
+const size_t BVH_MIN_SPHERES = 16;
+
+// Monta scene.bvh. Com cacheDir, procura <cacheDir>/<hash>.bvh e o mapeia direto; se não existir
+// ou não bater com a geometria, constrói e grava. Devolve true quando a hierarquia veio do cache.
+inline bool prepareSceneBVH(Scene& scene, const std::string& cacheDir) {
+    ArrayView<Sphere> spheres = scene.sphereView();
+    scene.bvh = nullptr;
+    if (spheres.size() < BVH_MIN_SPHERES) return false;
+
+    uint64_t hash = sceneGeometryHash(spheres, scene.planeView());
+    std::string path;
+    if (!cacheDir.empty()) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.bvh", static_cast<unsigned long long>(hash));
+        path = cacheDir + "/" + name;
+        std::shared_ptr<scenecache::MappedFile> file = std::make_shared<scenecache::MappedFile>();
+        if (file->open(path)) {
+            std::shared_ptr<BVH> cached = BVH::fromMemory(file->data, file->size, hash, spheres.size(), file);
+            if (cached) {
+                scene.bvh = cached;
+                return true;
+            }
+        }
+    }
+
+    std::shared_ptr<BVH> built = BVH::build(spheres, hash);
+    // Grava ao lado e renomeia: outro processo nunca mapeia um arquivo pela metade
+    if (!path.empty()) {
+#ifndef _WIN32
+        mkdir(cacheDir.c_str(), 0755);
+#endif
+        // pid e contador: nomes distintos entre processos e entre threads do mesmo processo
+        static std::atomic<unsigned> saves{ 0 };
+#ifdef _WIN32
+        long pid = _getpid();
+#else
+        long pid = getpid();
+#endif
+        std::string temporary = path + ".tmp" + std::to_string(pid) + "." + std::to_string(saves++);
+        if (!built->save(temporary) || std::rename(temporary.c_str(), path.c_str()) != 0) std::remove(temporary.c_str());
+    }
+    scene.bvh = built;
+    return false;
+}
+
+#endif // SCENE_CACHE_H
@@ -8,14 +8,32 @@
 
 class Sphere {
 public:
-    Point3 center;
+    Point3 center;  // posição na abertura do obturador (time = 0)
     double radius;
     Vec3 color;
+    Vec3 motion;    // deslocamento linear do centro até o fechamento do obturador (time = 1)
 
-    Sphere(Point3 c, double r, Vec3 col) : center(c), radius(r), color(col) {}
+    Sphere(Point3 c, double r, Vec3 col) : center(c), radius(r), color(col), motion(0, 0, 0) {}
+    Sphere(Point3 c, double r, Vec3 col, Vec3 m) : center(c), radius(r), color(col), motion(m) {}
+
+    Point3 centerAt(double time) const {
+        return Point3(center.x + motion.x * time, center.y + motion.y * time, center.z + motion.z * time);
+    }
+
+    // Esfera que envolve todo o trajeto durante o obturador
+    Point3 sweptCenter() const { return centerAt(0.5); }
+    double sweptRadius() const { return radius + 0.5 * motion.length(); }
+
+    Vec3 normalAt(const Ray& ray, double t) const {
+        Point3 c = centerAt(ray.time);
+        return Vec3(ray.origin.x + t * ray.direction.x - c.x,
+                    ray.origin.y + t * ray.direction.y - c.y,
+                    ray.origin.z + t * ray.direction.z - c.z) / radius;
+    }
 
     bool intersect(const Ray& ray, Intersection& intersection) const {
-        Vec3 oc(ray.origin.x - center.x, ray.origin.y - center.y, ray.origin.z - center.z);
+        Point3 current = centerAt(ray.time);
+        Vec3 oc(ray.origin.x - current.x, ray.origin.y - current.y, ray.origin.z - current.z);
         double a = ray.direction.dot(ray.direction);
         double b = 2.0 * oc.dot(ray.direction);
         double c = oc.dot(oc) - radius * radius;
@@ -25,13 +43,13 @@ public:
 
         double t = (-b - sqrt(discriminant)) / (2.0 * a);
         if (t > 0) {
-            intersection = Intersection(t, color);
+            intersection = Intersection(t, color, normalAt(ray, t));
             return true;
         }
 
         t = (-b + sqrt(discriminant)) / (2.0 * a);
         if (t > 0) {
-            intersection = Intersection(t, color);
+            intersection = Intersection(t, color, normalAt(ray, t));
             return true;
         }
 
@@ -0,0 +1,154 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <algorithm>
+
+// Pool de threads fixo compartilhado por vários pedidos de renderização. Cada índice de um
+// parallelFor vira uma tarefa própria na fila, então lotes de chamadores diferentes se
+// intercalam em vez de um esperar o outro terminar.
+class ThreadPool {
+public:
+    explicit ThreadPool(int threads = 0) {
+        int count = threads > 0 ? threads : int(std::max(1u, std::thread::hardware_concurrency()));
+        for (int i = 0; i < count; ++i) workers.emplace_back([this] { workerLoop(); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        available.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return int(workers.size()); }
+
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(task));
+        }
+        available.notify_one();
+    }
+
+    // Executa fn(i) para i em [0, count) e espera todos terminarem. Enquanto espera, a thread
+    // chamadora também consome a fila, o que permite chamar parallelFor de dentro de uma tarefa.
+    template <typename Fn>
+    void parallelFor(int count, const Fn& fn) {
+        if (count <= 0) return;
+        std::shared_ptr<Batch> batch = std::make_shared<Batch>();
+        batch->remaining = count;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (int i = 0; i < count; ++i) {
+                tasks.push_back([batch, &fn, i] {
+                    fn(i);
+                    std::lock_guard<std::mutex> batchLock(batch->mutex);
+                    if (--batch->remaining == 0) batch->finished.notify_all();
+                });
+            }
+        }
+        available.notify_all();
+
+        for (;;) {
+            {
+                std::lock_guard<std::mutex> batchLock(batch->mutex);
+                if (batch->remaining == 0) return;
+            }
+            std::function<void()> task;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!tasks.empty()) {
+                    task = std::move(tasks.front());
+                    tasks.pop_front();
+                }
+            }
+            if (task) {
+                task();
+                continue;
+            }
+            // Fila vazia: o resto do lote está rodando em outras threads
+            std::unique_lock<std::mutex> batchLock(batch->mutex);
+            batch->finished.wait(batchLock, [&] { return batch->remaining == 0; });
+            return;
+        }
+    }
+
+private:
+    struct Batch {
+        std::mutex mutex;
+        std::condition_variable finished;
+        int remaining = 0;
+    };
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable available;
+    bool stopping = false;
+
+    void workerLoop() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                available.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (tasks.empty()) return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+};
+
+// Fila limitada entre estágios de um pipeline: push bloqueia com a fila cheia, pop bloqueia
+// com ela vazia. Depois de close(), pop devolve false quando não há mais itens.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity(std::max<size_t>(1, capacity)) {}
+
+    void push(T item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this] { return items.size() < capacity; });
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+    }
+
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this] { return closed || !items.empty(); });
+        if (items.empty()) return false;
+        item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notEmpty.notify_all();
+    }
+
+private:
+    size_t capacity;
+    std::deque<T> items;
+    std::mutex mutex;
+    std::condition_variable notFull, notEmpty;
+    bool closed = false;
+};
+
+#endif // THREAD_POOL_H
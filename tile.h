@@ -0,0 +1,24 @@
+#ifndef TILE_H
+#define TILE_H
+
+#include <vector>
+#include <algorithm>
+
+class Tile {
+public:
+    int x0, y0, x1, y1;
+
+    Tile(int ax0, int ay0, int ax1, int ay1) : x0(ax0), y0(ay0), x1(ax1), y1(ay1) {}
+};
+
+inline std::vector<Tile> makeTiles(int width, int height, int tileSize) {
+    std::vector<Tile> tiles;
+    for (int y = 0; y < height; y += tileSize) {
+        for (int x = 0; x < width; x += tileSize) {
+            tiles.push_back(Tile(x, y, std::min(x + tileSize, width), std::min(y + tileSize, height)));
+        }
+    }
+    return tiles;
+}
+
+#endif // TILE_H
@@ -26,6 +26,11 @@ public:
         return Vec3(vec.x * scalar, vec.y * scalar, vec.z * scalar);
     }
 
+    // Produto componente a componente, usado para modular cores
+    Vec3 operator*(const Vec3& other) const {
+        return Vec3(x * other.x, y * other.y, z * other.z);
+    }
+
     Vec3 operator/(double scalar) const {
         return Vec3(x / scalar, y / scalar, z / scalar);
     }
@@ -42,6 +47,10 @@ public:
         );
     }
 
+    double length() const {
+        return std::sqrt(x * x + y * y + z * z);
+    }
+
     Vec3 normalize() const {
         double mag = std::sqrt(x * x + y * y + z * z);
         return *this / mag;